@@ -0,0 +1,571 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+/*! \file vader_benchmarks.cc
+ *
+ *  \brief Times Vader::changeVar and the mo functions on synthetic cubed-sphere
+ *         FieldSets, for a range of resolutions, level counts and thread counts.
+ *
+ *  \details Usage:
+ *
+ *      vader_benchmarks [--resolutions=48,96,...] [--levels=70,137] [--threads=1,2,4]
+ *                       [--precisions=double,float] [--repeats=5]
+ *                       [--output=vader_benchmarks.json]
+ *                       [--stress-threads=16] [--stress-iterations=20]
+ *
+ *           Resolutions are cubed-sphere face sizes (C48 to C768). Each kernel is run
+ *           once to warm up and then timed --repeats times; the fields are
+ *           re-initialised before every call, outside of the timed region. The
+ *           report is a JSON array with one entry per kernel, resolution, number of
+ *           levels, number of threads and precision of the fields, holding the median
+ *           and fastest wall times and the points (columns x levels) per second of the
+ *           median.
+ *
+ *           Fields follow the naming convention of the mo code: fields whose name
+ *           ends in "_levels" have one level more than the model levels, all other
+ *           fields (including "_levels_minus_one") have as many levels as the model.
+ *           The interpolation weights and vertical regression matrices of the
+ *           hydrostatic pressure are always double precision.
+ *
+ *           With --stress-threads, the program also checks that Vader is reentrant:
+ *           for the first resolution and number of levels, that many threads call
+ *           changeVar on a single shared Vader at the same time, --stress-iterations
+ *           times each, on FieldSets of their own with surface pressure in Pa or in
+ *           hPa, and the results are compared with those of sequential calls. The
+ *           program fails if any result differs.
+ */
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "atlas/array.h"
+#include "atlas/field.h"
+#include "atlas/functionspace/CubedSphereColumns.h"
+#include "atlas/grid.h"
+#include "atlas/library.h"
+#include "atlas/mesh.h"
+#include "atlas/meshgenerator.h"
+#include "atlas/option.h"
+
+#include "oops/base/Variables.h"
+
+#include "vader/vader.h"
+#include "vader/vadervariables.h"
+
+#ifdef VADER_BENCHMARKS_MO
+#include "mo/common_linearvarchange.h"
+#include "mo/common_varchange.h"
+#include "mo/constants.h"
+#include "mo/control2analysis_linearvarchange.h"
+#include "mo/control2analysis_varchange.h"
+#include "mo/functions.h"
+#include "mo/model2geovals_varchange.h"
+#endif
+
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+struct Options {
+    std::vector<int> resolutions{48};
+    std::vector<int> levels{70};
+    std::vector<int> threads{1};
+    std::vector<std::string> precisions{"double"};
+    int repeats = 5;
+    std::string output = "vader_benchmarks.json";
+    int stressThreads = 0;
+    int stressIterations = 20;
+};
+
+/// A kernel to time: the names of the fields it needs in the state and in the
+/// increment FieldSets, and the call itself.
+struct Kernel {
+    std::string name;
+    std::vector<std::string> stateFields;
+    std::vector<std::string> incrementFields;
+    std::function<void(atlas::FieldSet & state, atlas::FieldSet & increment)> run;
+};
+
+struct Result {
+    std::string kernel;
+    int resolution;
+    int levels;
+    int threads;
+    std::string precision;
+    std::size_t points;
+    double median;
+    double fastest;
+};
+
+// Number of bins of the hydrostatic pressure regression
+const atlas::idx_t nBins = 18;
+
+// ------------------------------------------------------------------------------------------------
+std::vector<int> parseList(const std::string & value) {
+    std::vector<int> list;
+    std::istringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) list.push_back(std::stoi(item));
+    return list;
+}
+// ------------------------------------------------------------------------------------------------
+std::vector<std::string> parseNames(const std::string & value) {
+    std::vector<std::string> names;
+    std::istringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) names.push_back(item);
+    return names;
+}
+// ------------------------------------------------------------------------------------------------
+Options parseOptions(int argc, char ** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        const std::size_t eq = arg.find('=');
+        const std::string key = arg.substr(0, eq);
+        const std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--resolutions") {
+            options.resolutions = parseList(value);
+        } else if (key == "--levels") {
+            options.levels = parseList(value);
+        } else if (key == "--threads") {
+            options.threads = parseList(value);
+        } else if (key == "--precisions") {
+            options.precisions = parseNames(value);
+        } else if (key == "--repeats") {
+            options.repeats = std::max(1, std::stoi(value));
+        } else if (key == "--output") {
+            options.output = value;
+        } else if (key == "--stress-threads") {
+            options.stressThreads = std::stoi(value);
+        } else if (key == "--stress-iterations") {
+            options.stressIterations = std::max(1, std::stoi(value));
+        } else {
+            std::cerr << "vader_benchmarks: ignoring unknown argument " << arg << std::endl;
+        }
+    }
+    return options;
+}
+// ------------------------------------------------------------------------------------------------
+bool endsWith(const std::string & name, const std::string & suffix) {
+    return name.size() >= suffix.size() &&
+           name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+bool contains(const std::string & name, const std::string & part) {
+    return name.find(part) != std::string::npos;
+}
+// ------------------------------------------------------------------------------------------------
+/// Synthetic but physically plausible value of a state variable at a level, as a
+/// function of the fractional height z (0 at the surface, 1 at the model top) and of
+/// a small horizontal perturbation
+double stateValue(const std::string & name, double z, double perturbation) {
+    const double pressure = 1.0e5 * std::exp(-3.0 * z);
+    if (name == vader::VV_PS || name == "surface_pressure") return 1.0e5 * (1.0 + perturbation);
+    if (contains(name, "exner")) return std::pow(pressure / 1.0e5, 0.2857) * (1.0 + perturbation);
+    if (contains(name, "pressure")) return pressure * (1.0 + perturbation);
+    if (name == vader::VV_TS) return 220.0 + 60.0 * (1.0 - z) + 5.0 * perturbation;
+    if (contains(name, "potential_temperature")) return 280.0 + 120.0 * z + 5.0 * perturbation;
+    if (contains(name, "height")) return 50.0 + 2.0e4 * z * (1.0 + 0.01 * perturbation);
+    if (name == "specific_humidity" || name == "qt" || name == "m_v" || name == "qsat") {
+        return 1.0e-6 + 1.0e-2 * std::exp(-5.0 * z) * (1.0 + 0.1 * perturbation);
+    }
+    if (name == "svp") return 1.0e3 * std::exp(-5.0 * z);
+    if (name == "dlsvpdT") return 0.06;
+    if (name == "interpolation_weights") return 1.0 / nBins;
+    if (name == "vertical_regression_matrices") return 1.0e-3;
+    if (contains(name, "relative_humidity") || name == "rht") return 0.8 + 0.1 * perturbation;
+    if (contains(name, "density")) return 1.2 * std::exp(-3.0 * z);
+    if (name == "m_t") return 1.01;
+    return 1.0e-5 * (1.0 + perturbation) + (contains(name, "mu") ? 0.5 : 0.0);
+}
+// ------------------------------------------------------------------------------------------------
+atlas::idx_t fieldLevels(const std::string & name, atlas::idx_t levels) {
+    if (name == vader::VV_PS || name == "relative_humidity_2m" || name == "param_a" ||
+        name == "param_b" || name == "specific_humidity_at_two_meters_above_surface") return 1;
+    if (name == "interpolation_weights") return nBins;
+    return endsWith(name, "_levels") ? levels + 1 : levels;
+}
+// ------------------------------------------------------------------------------------------------
+atlas::FieldSet createFields(const atlas::FunctionSpace & fspace,
+                             const std::vector<std::string> & names, atlas::idx_t levels,
+                             atlas::array::DataType datatype) {
+    atlas::FieldSet fields;
+    for (const auto & name : names) {
+        if (name == "vertical_regression_matrices") {
+            // Not a field on the function space: one (levels x levels) matrix per bin
+            fields.add(atlas::Field(name, atlas::array::make_datatype<double>(),
+                                    atlas::array::make_shape(nBins * levels, levels)));
+        } else {
+            const auto config = atlas::option::name(name) |
+                                atlas::option::levels(fieldLevels(name, levels));
+            if (name != "interpolation_weights" &&
+                datatype == atlas::array::DataType::real32()) {
+                fields.add(fspace.createField<float>(config));
+            } else {
+                fields.add(fspace.createField<double>(config));
+            }
+        }
+    }
+    if (fields.has("height")) fields["height"].metadata().set("boundary_layer_index", 10);
+    if (fields.has(vader::VV_PS)) fields[vader::VV_PS].metadata().set("units", "Pa");
+    return fields;
+}
+// ------------------------------------------------------------------------------------------------
+template <typename T>
+void initField(atlas::Field & field, double scale) {
+    auto view = atlas::array::make_view<T, 2>(field);
+    const atlas::idx_t levels = view.shape(1);
+    for (atlas::idx_t jn = 0; jn < view.shape(0); ++jn) {
+        const double perturbation = 0.01 * std::sin(0.37 * jn);
+        for (atlas::idx_t jl = 0; jl < levels; ++jl) {
+            const double z = levels > 1 ? static_cast<double>(jl) / (levels - 1) : 0.0;
+            view(jn, jl) = scale * stateValue(field.name(), z, perturbation);
+        }
+    }
+}
+// ------------------------------------------------------------------------------------------------
+void initFields(atlas::FieldSet & fields, double scale) {
+    for (auto & field : fields) {
+        if (field.datatype() == atlas::array::DataType::real32()) {
+            initField<float>(field, scale);
+        } else {
+            initField<double>(field, scale);
+        }
+    }
+}
+// ------------------------------------------------------------------------------------------------
+std::vector<Kernel> vaderKernels() {
+    const std::vector<std::string> fields{vader::VV_TS, vader::VV_PS, vader::VV_PT};
+    vader::VaderParameters parameters;
+    auto vader = std::make_shared<vader::Vader>(parameters);
+
+    std::vector<Kernel> kernels;
+    kernels.push_back({"vader::changeVar(potential_temperature)", fields, {},
+        [vader](atlas::FieldSet & state, atlas::FieldSet &) {
+            oops::Variables neededVars(std::vector<std::string>{vader::VV_PT});
+            vader->changeVar(state, neededVars);
+        }});
+    auto plan = std::make_shared<vader::ChangeVarPlan>(
+        vader->compile(fields, oops::Variables(std::vector<std::string>{vader::VV_PT})));
+    kernels.push_back({"vader::changeVar(plan)", fields, {},
+        [vader, plan](atlas::FieldSet & state, atlas::FieldSet &) {
+            vader->changeVar(state, *plan);
+        }});
+    return kernels;
+}
+// ------------------------------------------------------------------------------------------------
+#ifdef VADER_BENCHMARKS_MO
+std::vector<Kernel> moKernels() {
+    const std::string qcl = "mass_content_of_cloud_liquid_water_in_atmosphere_layer";
+    const std::string qcf = "mass_content_of_cloud_ice_in_atmosphere_layer";
+    typedef std::vector<std::string> Names;
+
+    // Nonlinear functions only use the state
+    auto nl = [](const std::string & name, const Names & fields,
+                 std::function<void(atlas::FieldSet &)> f) {
+        return Kernel{name, fields, {},
+                      [f](atlas::FieldSet & state, atlas::FieldSet &) {f(state);}};
+    };
+    // Linear functions use the increment and the (augmented) state
+    auto lin = [](const std::string & name, const Names & state, const Names & increment,
+                  std::function<void(atlas::FieldSet &, const atlas::FieldSet &)> f) {
+        return Kernel{name, state, increment,
+                      [f](atlas::FieldSet & aug, atlas::FieldSet & inc) {f(inc, aug);}};
+    };
+
+    const Names vthetaState{"specific_humidity", "potential_temperature"};
+    const Names vthetaInc{"specific_humidity", "potential_temperature",
+                          "virtual_potential_temperature"};
+    const Names hexnerState{"height_levels", "virtual_potential_temperature",
+                            "air_pressure_levels_minus_one", "hydrostatic_exner_levels"};
+    const Names hexnerInc{"virtual_potential_temperature", "air_pressure_levels_minus_one",
+                          "hydrostatic_exner_levels"};
+    const Names rhoState{"height_levels", "height", "exner_levels_minus_one",
+                         "potential_temperature", "dry_air_density_levels_minus_one"};
+    const Names rhoInc{"exner_levels_minus_one", "potential_temperature",
+                       "dry_air_density_levels_minus_one"};
+    const Names tState{"height_levels", "height", "exner_levels_minus_one",
+                       "potential_temperature"};
+    const Names tInc{"exner_levels_minus_one", "potential_temperature", "air_temperature"};
+    const Names qtInc{"specific_humidity", qcl, qcf, "qt"};
+    const Names cloudState{"qsat", "dlsvpdT", "cleff", "cfeff"};
+    const Names cloudInc{"qt", "air_temperature", "specific_humidity", qcl, qcf};
+    const Names hpState{"air_pressure_levels", "interpolation_weights",
+                        "vertical_regression_matrices"};
+    const Names hpInc{"geostrophic_pressure_levels_minus_one",
+                      "unbalanced_pressure_levels_minus_one", "hydrostatic_pressure_levels"};
+    const Names hexState{"hydrostatic_pressure_levels", "hydrostatic_exner_levels"};
+    const Names hexInc{"hydrostatic_pressure_levels", "hydrostatic_exner_levels"};
+    const Names muState{"muRecipDeterminant", "muRow1Column1", "muRow1Column2",
+                        "muRow2Column1", "muRow2Column2"};
+    const Names muInc{"potential_temperature", "qt", "mu", "virtual_potential_temperature"};
+
+    std::vector<Kernel> kernels{
+        nl("mo::evalSatSpecificHumidity", {"air_pressure", "svp", "air_temperature", "qsat"},
+           [](atlas::FieldSet & f) {mo::evalSatSpecificHumidity(f);}),
+        nl("mo::evalAirPressureLevels", {"exner_levels_minus_one", "air_pressure_levels_minus_one",
+           "potential_temperature", "height_levels", "air_pressure_levels"},
+           [](atlas::FieldSet & f) {mo::evalAirPressureLevels(f);}),
+        nl("mo::hexner2PThetav", {"height_levels", "hydrostatic_exner_levels",
+           "air_pressure_levels_minus_one", "virtual_potential_temperature"}, mo::hexner2PThetav),
+        nl("mo::evalVirtualPotentialTemperature", vthetaInc, mo::evalVirtualPotentialTemperature),
+        nl("mo::evalHydrostaticExnerLevels", {"height_levels", "virtual_potential_temperature",
+           "air_pressure_levels_minus_one", "hydrostatic_exner_levels"},
+           mo::evalHydrostaticExnerLevels),
+        nl("mo::evalHydrostaticPressureLevels", {"hydrostatic_exner_levels",
+           "hydrostatic_pressure_levels"}, mo::evalHydrostaticPressureLevels),
+        nl("mo::qqclqcf2qt", qtInc, mo::qqclqcf2qt),
+        nl("mo::evalDryAirDensity", {"height_levels", "height", "air_temperature",
+           "air_pressure_levels_minus_one", "dry_air_density_levels_minus_one"},
+           mo::evalDryAirDensity),
+        nl("mo::evalExnerPressureLevels", {"exner_levels_minus_one",
+           "virtual_potential_temperature", "height_levels", "exner_pressure_levels"},
+           mo::evalExnerPressureLevels),
+        nl("mo::evalMoistureControlDependencies", {"qt", "specific_humidity",
+           "potential_temperature", "exner", "dlsvpdT", "qsat", "muA", "muH1", "muRow1Column1",
+           "muRow1Column2", "muRow2Column1", "muRow2Column2", "muRecipDeterminant"},
+           mo::evalMoistureControlDependencies),
+        nl("mo::evalTotalMassMoistAir", {"m_v", "m_ci", "m_cl", "m_r", "m_t"},
+           [](atlas::FieldSet & f) {mo::evalTotalMassMoistAir(f);}),
+        nl("mo::evalSpecificHumidity", {"m_v", "m_t", "specific_humidity"},
+           [](atlas::FieldSet & f) {mo::evalSpecificHumidity(f);}),
+        nl("mo::evalRelativeHumidity", {"specific_humidity", "qsat", "relative_humidity"},
+           [](atlas::FieldSet & f) {mo::evalRelativeHumidity(f);}),
+        nl("mo::evalTotalRelativeHumidity", {"specific_humidity", qcl, qcf, "qrain", "qsat",
+           "rht"}, [](atlas::FieldSet & f) {mo::evalTotalRelativeHumidity(f);}),
+        nl("mo::evalAirTemperature", {"potential_temperature", "exner", "air_temperature"},
+           [](atlas::FieldSet & f) {mo::evalAirTemperature(f);}),
+        nl("mo::evalSpecificHumidityFromRH_2m", {"qsat", "relative_humidity_2m",
+           "specific_humidity_at_two_meters_above_surface"},
+           [](atlas::FieldSet & f) {mo::evalSpecificHumidityFromRH_2m(f);}),
+        nl("mo::evalParamAParamB", {"height", "height_levels", "air_pressure_levels_minus_one",
+           "specific_humidity", "param_a", "param_b"},
+           [](atlas::FieldSet & f) {mo::evalParamAParamB(f);}),
+        lin("mo::evalVirtualPotentialTemperatureTL", vthetaState, vthetaInc,
+            mo::evalVirtualPotentialTemperatureTL),
+        lin("mo::evalVirtualPotentialTemperatureAD", vthetaState, vthetaInc,
+            mo::evalVirtualPotentialTemperatureAD),
+        lin("mo::thetavP2HexnerTL", hexnerState, hexnerInc, mo::thetavP2HexnerTL),
+        lin("mo::thetavP2HexnerAD", hexnerState, hexnerInc, mo::thetavP2HexnerAD),
+        lin("mo::hexner2ThetavTL", hexnerState, hexnerInc, mo::hexner2ThetavTL),
+        lin("mo::hexner2ThetavAD", hexnerState, hexnerInc, mo::hexner2ThetavAD),
+        lin("mo::evalDryAirDensityTL", rhoState, rhoInc, mo::evalDryAirDensityTL),
+        lin("mo::evalDryAirDensityAD", rhoState, rhoInc, mo::evalDryAirDensityAD),
+        lin("mo::evalAirTemperatureTL", tState, tInc, mo::evalAirTemperatureTL),
+        lin("mo::evalAirTemperatureAD", tState, tInc, mo::evalAirTemperatureAD),
+        lin("mo::qqclqcf2qtTL", {}, qtInc, mo::qqclqcf2qtTL),
+        lin("mo::qqclqcf2qtAD", {}, qtInc, mo::qqclqcf2qtAD),
+        lin("mo::qtTemperature2qqclqcfTL", cloudState, cloudInc, mo::qtTemperature2qqclqcfTL),
+        lin("mo::qtTemperature2qqclqcfAD", cloudState, cloudInc, mo::qtTemperature2qqclqcfAD),
+        lin("mo::evalHydrostaticPressureTL", hpState, hpInc, mo::evalHydrostaticPressureTL),
+        lin("mo::evalHydrostaticPressureAD", hpState, hpInc, mo::evalHydrostaticPressureAD),
+        lin("mo::evalHydrostaticExnerTL", hexState, hexInc, mo::evalHydrostaticExnerTL),
+        lin("mo::evalHydrostaticExnerAD", hexState, hexInc, mo::evalHydrostaticExnerAD),
+        lin("mo::evalMuThetavTL", muState, muInc, mo::evalMuThetavTL),
+        lin("mo::evalMuThetavAD", muState, muInc, mo::evalMuThetavAD),
+        lin("mo::evalQtThetaTL", muState, muInc, mo::evalQtThetaTL),
+        lin("mo::evalQtThetaAD", muState, muInc, mo::evalQtThetaAD),
+    };
+
+    // These need the lookup table files, which are only there when run from a directory
+    // holding the test data
+    if (std::ifstream(mo::constants::commonVarChangeFilePath).good()) {
+        kernels.push_back(nl("mo::evalSatVaporPressure", {"air_temperature", "svp", "dlsvpdT"},
+                             [](atlas::FieldSet & f) {mo::evalSatVaporPressure(f);}));
+    }
+    if (std::ifstream(mo::constants::mioCoefficientsFilePath).good()) {
+        kernels.push_back(nl("mo::getMIOFields", {"rht",
+            "liquid_cloud_volume_fraction_in_atmosphere_layer",
+            "ice_cloud_volume_fraction_in_atmosphere_layer", "cleff", "cfeff"},
+            mo::functions::getMIOFields));
+    }
+    return kernels;
+}
+#endif
+// ------------------------------------------------------------------------------------------------
+void setThreads(int threads) {
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+}
+// ------------------------------------------------------------------------------------------------
+Result runKernel(const Kernel & kernel, const atlas::FunctionSpace & fspace,
+                 int resolution, int levels, int threads, const std::string & precision,
+                 int repeats) {
+    const atlas::array::DataType datatype = precision == "float" ?
+        atlas::array::DataType::real32() : atlas::array::DataType::real64();
+    atlas::FieldSet state = createFields(fspace, kernel.stateFields, levels, datatype);
+    atlas::FieldSet increment = createFields(fspace, kernel.incrementFields, levels, datatype);
+
+    std::vector<double> times;
+    for (int repeat = 0; repeat <= repeats; ++repeat) {
+        initFields(state, 1.0);
+        initFields(increment, 1.0e-3);
+        const auto start = std::chrono::steady_clock::now();
+        kernel.run(state, increment);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (repeat > 0) times.push_back(elapsed.count());  // the first call is a warm-up
+    }
+    std::sort(times.begin(), times.end());
+
+    Result result{kernel.name, resolution, levels, threads, precision,
+                  static_cast<std::size_t>(fspace.size()) * levels,
+                  times[times.size() / 2], times.front()};
+    return result;
+}
+// ------------------------------------------------------------------------------------------------
+/// FieldSet for the stress test, with the surface pressure in the given units
+atlas::FieldSet stressFields(const atlas::FunctionSpace & fspace, atlas::idx_t levels,
+                             const std::string & units) {
+    atlas::FieldSet fields = createFields(fspace, {vader::VV_TS, vader::VV_PS, vader::VV_PT},
+                                          levels, atlas::array::DataType::real64());
+    initFields(fields, 1.0);
+    if (units == "hPa") {
+        auto view = atlas::array::make_view<double, 2>(fields[vader::VV_PS]);
+        for (atlas::idx_t jn = 0; jn < view.shape(0); ++jn) view(jn, 0) *= 0.01;
+    }
+    fields[vader::VV_PS].metadata().set("units", units);
+    return fields;
+}
+// ------------------------------------------------------------------------------------------------
+bool sameValues(const atlas::Field & field, const atlas::Field & reference) {
+    const auto view = atlas::array::make_view<const double, 2>(field);
+    const auto referenceView = atlas::array::make_view<const double, 2>(reference);
+    for (atlas::idx_t jn = 0; jn < view.shape(0); ++jn) {
+        for (atlas::idx_t jl = 0; jl < view.shape(1); ++jl) {
+            if (view(jn, jl) != referenceView(jn, jl)) return false;
+        }
+    }
+    return true;
+}
+// ------------------------------------------------------------------------------------------------
+/// Calls changeVar for potential temperature from nthreads threads at once on one
+/// Vader, alternately planning each call and executing a shared compiled plan, and
+/// returns the number of results that differ from those of sequential calls
+int stressTest(const atlas::FunctionSpace & fspace, atlas::idx_t levels, int nthreads,
+               int iterations) {
+    const std::vector<std::string> units{"Pa", "hPa"};
+    vader::VaderParameters parameters;
+    const vader::Vader vader(parameters);
+    const oops::Variables neededVars(std::vector<std::string>{vader::VV_PT});
+
+    std::vector<atlas::FieldSet> references;
+    for (const auto & unit : units) {
+        references.push_back(stressFields(fspace, levels, unit));
+        oops::Variables vars(neededVars);
+        vader.changeVar(references.back(), vars);
+    }
+    const vader::ChangeVarPlan plan = vader.compile(references.front().field_names(), neededVars);
+
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < nthreads; ++thread) {
+        threads.emplace_back([&, thread]() {
+            setThreads(1);
+            const std::size_t unit = thread % units.size();
+            atlas::FieldSet fields = stressFields(fspace, levels, units[unit]);
+            for (int iteration = 0; iteration < iterations; ++iteration) {
+                initField<double>(fields[vader::VV_PT], 0.0);
+                if (iteration % 2 == 0) {
+                    oops::Variables vars(neededVars);
+                    vader.changeVar(fields, vars);
+                } else {
+                    vader.changeVar(fields, plan);
+                }
+                if (!sameValues(fields[vader::VV_PT], references[unit][vader::VV_PT])) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto & thread : threads) thread.join();
+    return failures;
+}
+// ------------------------------------------------------------------------------------------------
+void writeReport(const std::vector<Result> & results, std::ostream & os) {
+    os << "[" << std::endl;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result & r = results[i];
+        os << "  {\"kernel\": \"" << r.kernel << "\", \"grid\": \"C" << r.resolution
+           << "\", \"levels\": " << r.levels << ", \"threads\": " << r.threads
+           << ", \"precision\": \"" << r.precision << "\""
+           << ", \"points\": " << r.points << ", \"median_s\": " << r.median
+           << ", \"fastest_s\": " << r.fastest
+           << ", \"points_per_s\": " << r.points / std::max(r.median, 1.0e-12) << "}"
+           << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    os << "]" << std::endl;
+}
+
+}  // namespace
+
+// ------------------------------------------------------------------------------------------------
+int main(int argc, char ** argv) {
+    atlas::initialize(argc, argv);
+    const Options options = parseOptions(argc, argv);
+
+    std::vector<Kernel> kernels = vaderKernels();
+#ifdef VADER_BENCHMARKS_MO
+    for (auto & kernel : moKernels()) kernels.push_back(kernel);
+#endif
+
+    std::vector<Result> results;
+    for (int resolution : options.resolutions) {
+        const atlas::Grid grid("CS-LFR-C" + std::to_string(resolution));
+        const atlas::Mesh mesh = atlas::MeshGenerator("cubedsphere").generate(grid);
+        const atlas::functionspace::CubedSphereNodeColumns fspace(mesh);
+        for (int levels : options.levels) {
+            for (int threads : options.threads) {
+                setThreads(threads);
+                for (const auto & precision : options.precisions) {
+                    for (const auto & kernel : kernels) {
+                        results.push_back(runKernel(kernel, fspace, resolution, levels,
+                                                    threads, precision, options.repeats));
+                        const Result & r = results.back();
+                        std::cout << r.kernel << " C" << r.resolution << " L" << r.levels
+                                  << " " << r.threads << " thread(s) " << r.precision << ": "
+                                  << r.median << " s, "
+                                  << r.points / std::max(r.median, 1.0e-12) << " points/s"
+                                  << std::endl;
+                    }
+                }
+            }
+        }
+    }
+
+    std::ofstream report(options.output);
+    writeReport(results, report);
+    std::cout << "vader_benchmarks: report written to " << options.output << std::endl;
+
+    int failures = 0;
+    if (options.stressThreads > 0) {
+        const atlas::Grid grid("CS-LFR-C" + std::to_string(options.resolutions.front()));
+        const atlas::Mesh mesh = atlas::MeshGenerator("cubedsphere").generate(grid);
+        const atlas::functionspace::CubedSphereNodeColumns fspace(mesh);
+        failures = stressTest(fspace, options.levels.front(), options.stressThreads,
+                              options.stressIterations);
+        std::cout << "vader_benchmarks: stress test with " << options.stressThreads
+                  << " threads x " << options.stressIterations << " changeVar calls "
+                  << (failures == 0 ? "passed" : "FAILED") << " (" << failures
+                  << " wrong result(s))" << std::endl;
+    }
+
+    atlas::finalize();
+    return failures == 0 ? 0 : 1;
+}
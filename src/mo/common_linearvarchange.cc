@@ -12,6 +12,8 @@
 #include "mo/constants.h"
 #include "mo/functions.h"
 
+#include "vader/StatsRegistry.h"
+
 using atlas::array::make_view;
 using atlas::idx_t;
 using atlas::util::Config;
@@ -20,13 +22,19 @@ namespace mo {
 
 /// \details Calculate the tangent linear of virtual potential temperature
 ///          from the specific humidity and the potential temperature.
+template <typename T>
 void evalVirtualPotentialTemperatureTL(atlas::FieldSet & incFlds,
                                        const atlas::FieldSet & augStateFlds) {
-  const auto qView = make_view<const double, 2>(augStateFlds["specific_humidity"]);
-  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
-  const auto qIncView = make_view<const double, 2>(incFlds["specific_humidity"]);
-  const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
-  auto vthetaIncView = make_view<double, 2>(incFlds["virtual_potential_temperature"]);
+  vader::ScopedKernelTimer timer("mo::evalVirtualPotentialTemperatureTL");
+  timer.reads(augStateFlds, {"specific_humidity", "potential_temperature"})
+       .reads(incFlds, {"specific_humidity", "potential_temperature"})
+       .writes(incFlds, {"virtual_potential_temperature"});
+
+  const auto qView = make_view<const T, 2>(augStateFlds["specific_humidity"]);
+  const auto thetaView = make_view<const T, 2>(augStateFlds["potential_temperature"]);
+  const auto qIncView = make_view<const T, 2>(incFlds["specific_humidity"]);
+  const auto thetaIncView = make_view<const T, 2>(incFlds["potential_temperature"]);
+  auto vthetaIncView = make_view<T, 2>(incFlds["virtual_potential_temperature"]);
 
   auto fspace = incFlds["virtual_potential_temperature"].functionspace();
 
@@ -41,15 +49,30 @@ void evalVirtualPotentialTemperatureTL(atlas::FieldSet & incFlds,
   functions::parallelFor(fspace, evaluateVThetaTL, conf);
 }
 
+void evalVirtualPotentialTemperatureTL(atlas::FieldSet & incFlds,
+                                       const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(incFlds["virtual_potential_temperature"], [&](auto precision) {
+    return evalVirtualPotentialTemperatureTL<decltype(precision)>(incFlds, augStateFlds);
+  });
+}
+
 /// \details Calculate the tangent linear of virtual potential temperature
 ///          from the specific humidity and the potential temperature.
+template <typename T>
 void evalVirtualPotentialTemperatureAD(atlas::FieldSet & hatFlds,
                                        const atlas::FieldSet & augStateFlds) {
-  const auto qView = make_view<const double, 2>(augStateFlds["specific_humidity"]);
-  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
-  auto qHatView = make_view<double, 2>(hatFlds["specific_humidity"]);
-  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
-  auto vthetaHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
+  vader::ScopedKernelTimer timer("mo::evalVirtualPotentialTemperatureAD");
+  timer.reads(augStateFlds, {"specific_humidity", "potential_temperature"})
+       .reads(hatFlds, {"specific_humidity", "potential_temperature",
+                        "virtual_potential_temperature"})
+       .writes(hatFlds, {"specific_humidity", "potential_temperature",
+                         "virtual_potential_temperature"});
+
+  const auto qView = make_view<const T, 2>(augStateFlds["specific_humidity"]);
+  const auto thetaView = make_view<const T, 2>(augStateFlds["potential_temperature"]);
+  auto qHatView = make_view<T, 2>(hatFlds["specific_humidity"]);
+  auto thetaHatView = make_view<T, 2>(hatFlds["potential_temperature"]);
+  auto vthetaHatView = make_view<T, 2>(hatFlds["virtual_potential_temperature"]);
 
   auto fspace = hatFlds["virtual_potential_temperature"].functionspace();
 
@@ -65,5 +88,12 @@ void evalVirtualPotentialTemperatureAD(atlas::FieldSet & hatFlds,
   functions::parallelFor(fspace, evaluateVThetaAD, conf);
 }
 
+void evalVirtualPotentialTemperatureAD(atlas::FieldSet & hatFlds,
+                                       const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(hatFlds["specific_humidity"], [&](auto precision) {
+    return evalVirtualPotentialTemperatureAD<decltype(precision)>(hatFlds, augStateFlds);
+  });
+}
+
 
 }  // namespace mo
@@ -24,10 +24,15 @@
 #include "mo/common_varchange.h"
 #include "mo/constants.h"
 #include "mo/functions.h"
+#include "mo/lookup_tables.h"
+#ifdef VADER_MO_SVP_TABLES
+#include "mo/svp_tables.h"
+#endif
 
 #include "oops/base/Variables.h"
 #include "oops/util/Logger.h"
 
+#include "vader/StatsRegistry.h"
 #include "vader/vadervariables.h"
 
 using atlas::array::make_view;
@@ -35,46 +40,66 @@ using atlas::idx_t;
 
 namespace mo {
 
-bool evalSatVaporPressure(atlas::FieldSet & fields)
-{
-  oops::Log::trace() << "[svp()] starting ..." << std::endl;
-
-  // normalised T lambda function
-  // which enforces upper and lower bounds on T
-  auto normalisedT = [](const double tVal) {
-    double t = (tVal - constants::TLoBound)/constants::Tinc;
-    double t1 = (t < 0.0 ? 0.0 : t);
-    double t2 = (t1 >= static_cast<double>(constants::svpLookUpLength - 1)) ?
-                       static_cast<double>(constants::svpLookUpLength - 1) : t1;
-    return t2;
-  };
+namespace {
+
+/// \brief interpolates a table on the temperature grid of the svp lookup tables
+///        (TLoBound to THiBound by Tinc) to the temperatures of the selected
+///        columns; temperatures outside the grid are clamped to its bounds.
+///        Columns are processed in parallel, and the loop over levels is vectorised:
+///        the index and weight are private to each level and the table values are
+///        gathered without bounds checks, the index being within the table.
+template <typename T, typename InView, typename OutView>
+void interpolateSVPTable(const double * table, const InView & tView, OutView & outView,
+                         const vader::ColumnSelection & columns) {
+  const idx_t levels = outView.shape(1);
+  const idx_t ncolumns = columns.size(outView.shape(0));
+  const idx_t * selected = columns.all() ? nullptr : columns.columns().data();
+  const double maxNormalisedT = static_cast<double>(constants::svpLookUpLength - 1);
+
+#pragma omp parallel for schedule(static)
+  for (idx_t k = 0; k < ncolumns; ++k) {
+    const idx_t jn = selected ? selected[k] : k;
+    const T * t = &tView(jn, 0);
+    T * out = &outView(jn, 0);
+#pragma omp simd
+    for (idx_t jl = 0; jl < levels; ++jl) {
+      // normalised temperature, within the bounds of the table
+      const double normalisedT = std::min(std::max((t[jl] - constants::TLoBound) /
+                                                   constants::Tinc, 0.0), maxNormalisedT);
+      // index of the lower bound of the interval, avoiding the last index in the table
+      const int indx = std::min(static_cast<int>(normalisedT), constants::svpLookUpLength - 2);
+      const double w = normalisedT - static_cast<double>(indx);
+      out[jl] = w * table[indx + 1] + (1 - w) * table[indx];
+    }
+  }
+}
 
-  // lambda function returning the index of a given temperature value;
-  // avoids returning last index in table
-  auto index = [](const double normalisedTVal) {
-    std::size_t i = static_cast<std::size_t>(normalisedTVal);
-    return (i == constants::svpLookUpLength - 1 ? constants::svpLookUpLength - 2 : i);
-  };
+#ifndef VADER_MO_SVP_TABLES
+/// \brief names of the svp lookup tables in their file
+oops::Variables svpLookUpVars() {
+  return oops::Variables(std::vector<std::string>{"svp", "dlsvp", "svpW", "dlsvpW"});
+}
+#endif
 
-  // weight lamba function
-  auto weight = [index](const double normalisedTVal) {
-    std::size_t i = index(normalisedTVal);
-    return ( normalisedTVal -  static_cast<double>(i) );
-  };
+}  // namespace
 
-  // lambda function to interpolate values from table to given temperature
-  auto interp = [](const double weight, const double v1, const double v2) {
-     return (weight * v2 + (1 - weight) * v1);
-  };
+void loadSatVaporPressureTables(const eckit::mpi::Comm & comm) {
+#ifdef VADER_MO_SVP_TABLES
+  // The tables are generated at build time
+#else
+  LookUpTableRegistry::global().get(constants::commonVarChangeFilePath, svpLookUpVars(),
+                                    constants::svpLookUpLength, comm);
+#endif
+}
 
-  // lambda function to determine the gradient of variable in table
-  // with respect to temperature
-  auto normalisedDiff = [](const double v1, const double v2) {
-     return (v2 - v1)/ constants::Tinc;
-  };
+template <typename T>
+bool evalSatVaporPressure(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
+{
+  oops::Log::trace() << "[svp()] starting ..." << std::endl;
 
-  double w;  // weight
-  std::size_t indx;  // index
+  vader::ScopedKernelTimer timer("mo::evalSatVaporPressure", columns);
+  timer.reads(fields, {"air_temperature"})
+       .writes(fields, {"svp", "dlsvpdT"});
 
   // The check for the presence of required input fields will be performed by the Vader
   // algorithm when this code is in a Vader Recipe. At that time this check can be removed.
@@ -88,32 +113,29 @@ bool evalSatVaporPressure(atlas::FieldSet & fields)
     // svp field not compatible with air temperature field, cannot continue.
     return false;
   }
-  const auto tView  = make_view<const double, 2>(fields["air_temperature"]);
-  const std::vector<std::string> vars{"svp", "dlsvp", "svpW", "dlsvpW"};
-  oops::Variables lookUpVars(vars);
-  auto lookUpData = functions::getLookUps(constants::commonVarChangeFilePath, lookUpVars,
-                               constants::svpLookUpLength);
+  const auto tView  = make_view<const T, 2>(fields["air_temperature"]);
+  // svp, dlsvp, svpW and dlsvpW tables
+#ifdef VADER_MO_SVP_TABLES
+  // generated at build time
+  const std::vector<const double *> lookUpData{svptables::svp, svptables::dlsvp,
+                                               svptables::svpW, svptables::dlsvpW};
+#else
+  // The tables are those loaded by loadSatVaporPressureTables, or are read from the
+  // file on the first call
+  const std::vector<LookUpTable> lookUpTables = LookUpTableRegistry::global().get(
+    constants::commonVarChangeFilePath, svpLookUpVars(), constants::svpLookUpLength);
+  std::vector<const double *> lookUpData;
+  for (const auto & table : lookUpTables) lookUpData.push_back(table.data());
+#endif
 
   const std::vector<std::string> fnames {"svp", "dlsvpdT"};
   int ival = 0;  // set ival = 2 to get svp wrt water
   for (auto & ef : fnames) {
     if (fields.has(ef)) {
-      auto svpView = make_view<double, 2>(fields[ef]);
-
-      auto conf = atlas::util::Config("levels", fields[ef].levels()) |
-                  atlas::util::Config("include_halo", true);
-
+      auto svpView = make_view<T, 2>(fields[ef]);
       // check this recipe to calculate svp is correct
-      const std::vector<double> Lookup = lookUpData[ival];
+      interpolateSVPTable<T>(lookUpData[ival], tView, svpView, columns);
       ++ival;
-      auto evaluateSVP = [&] (atlas::idx_t i, atlas::idx_t j) {
-      indx = index(normalisedT(tView(i, j)));
-      w = weight(normalisedT(tView(i, j)));
-      svpView(i, j) = interp(w, Lookup.at(indx), Lookup.at(indx+1)); };
-
-      auto fspace = fields[ef].functionspace();
-
-      functions::parallelFor(fspace, evaluateSVP, conf);
     }
   }
 
@@ -122,26 +144,37 @@ bool evalSatVaporPressure(atlas::FieldSet & fields)
   return true;
 }
 
-bool evalSatSpecificHumidity(atlas::FieldSet & fields)
+bool evalSatVaporPressure(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
+{
+  return functions::dispatchPrecision(fields["air_temperature"], [&](auto precision) {
+    return evalSatVaporPressure<decltype(precision)>(fields, columns);
+  });
+}
+
+template <typename T>
+bool evalSatSpecificHumidity(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
 {
   oops::Log::trace() << "[getQsat()] starting ..." << std::endl;
 
-  const auto pbarView = make_view<const double, 2>(fields["air_pressure"]);
-  const auto svpView = make_view<const double, 2>(fields["svp"]);
-  const auto tView = make_view<const double, 2>(fields["air_temperature"]);
-  auto qsatView = make_view<double, 2>(fields["qsat"]);
+  vader::ScopedKernelTimer timer("mo::evalSatSpecificHumidity", columns);
+  timer.reads(fields, {"air_pressure", "svp", "air_temperature"})
+       .writes(fields, {"qsat"});
+
+  const auto pbarView = make_view<const T, 2>(fields["air_pressure"]);
+  const auto svpView = make_view<const T, 2>(fields["svp"]);
+  const auto tView = make_view<const T, 2>(fields["air_temperature"]);
+  auto qsatView = make_view<T, 2>(fields["qsat"]);
 
   auto conf = atlas::util::Config("levels", fields["qsat"].levels()) |
               atlas::util::Config("include_halo", true);
 
-  double fsubw;
   auto evaluateQsat = [&] (atlas::idx_t i, atlas::idx_t j) {
     // This formula for fsubw
     // is taken from equation A4.7 of Adrian Gill's book: Atmosphere-Ocean
     // Dynamics.  Note that his formula works in terms of pressure in MB and
     // temperature in Celsius, so conversion of units leads to the slightly
     // different equation used here.
-    fsubw = 1.0 + 1.0E-8 * pbarView(i, j) * (4.5 +
+    const double fsubw = 1.0 + 1.0E-8 * pbarView(i, j) * (4.5 +
             6.0e-4 * (tView(i, j) - constants::zerodegc) *
                      (tView(i, j) - constants::zerodegc));
 
@@ -154,25 +187,38 @@ bool evalSatSpecificHumidity(atlas::FieldSet & fields)
 
   auto fspace = fields["qsat"].functionspace();
 
-  functions::parallelFor(fspace, evaluateQsat, conf);
+  functions::parallelFor(fspace, columns, evaluateQsat, conf);
 
   oops::Log::trace() << "[getQsat()] ... exit" << std::endl;
 
   return true;
 }
 
-bool evalAirPressureLevels(atlas::FieldSet & fields)
+bool evalSatSpecificHumidity(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
+{
+  return functions::dispatchPrecision(fields["qsat"], [&](auto precision) {
+    return evalSatSpecificHumidity<decltype(precision)>(fields, columns);
+  });
+}
+
+template <typename T>
+bool evalAirPressureLevels(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
 {
   oops::Log::trace() << "[evalAirPressureLevels()] starting ..." << std::endl;
 
-  const auto ds_elmo = make_view<const double, 2>(fields["exner_levels_minus_one"]);
-  const auto ds_plmo = make_view<const double, 2>(fields["air_pressure_levels_minus_one"]);
-  const auto ds_t = make_view<const double, 2>(fields["potential_temperature"]);
-  const auto ds_hl = make_view<const double, 2>(fields["height_levels"]);
-  auto ds_pl = make_view<double, 2>(fields["air_pressure_levels"]);
+  vader::ScopedKernelTimer timer("mo::evalAirPressureLevels", columns);
+  timer.reads(fields, {"exner_levels_minus_one", "air_pressure_levels_minus_one",
+                       "potential_temperature", "height_levels"})
+       .writes(fields, {"air_pressure_levels"});
+
+  const auto ds_elmo = make_view<const T, 2>(fields["exner_levels_minus_one"]);
+  const auto ds_plmo = make_view<const T, 2>(fields["air_pressure_levels_minus_one"]);
+  const auto ds_t = make_view<const T, 2>(fields["potential_temperature"]);
+  const auto ds_hl = make_view<const T, 2>(fields["height_levels"]);
+  auto ds_pl = make_view<T, 2>(fields["air_pressure_levels"]);
 
   idx_t levels(fields["air_pressure_levels"].levels());
-  for (idx_t jn = 0; jn < fields["air_pressure_levels"].shape(0); ++jn) {
+  columns.forEach(fields["air_pressure_levels"].shape(0), [&](idx_t jn) {
     for (idx_t jl = 0; jl < levels - 1; ++jl) {
       ds_pl(jn, jl) = ds_plmo(jn, jl);
     }
@@ -194,11 +240,18 @@ bool evalAirPressureLevels(atlas::FieldSet & fields)
       (constants::cp * ds_t(jn, levels-2)), (1.0 / constants::rd_over_cp));
 
     ds_pl(jn, levels-1) = ds_pl(jn, levels-1) > 0.0 ? ds_pl(jn, levels-1) : constants::deps;
-  }
+  });
 
   oops::Log::trace() << "[evalAirPressureLevels()] ... exit" << std::endl;
 
   return true;
 }
 
+bool evalAirPressureLevels(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
+{
+  return functions::dispatchPrecision(fields["air_pressure_levels"], [&](auto precision) {
+    return evalAirPressureLevels<decltype(precision)>(fields, columns);
+  });
+}
+
 }  // namespace mo
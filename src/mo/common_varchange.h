@@ -13,17 +13,34 @@
 #include "atlas/field/Field.h"
 #include "atlas/field/FieldSet.h"
 
+#include "eckit/mpi/Comm.h"
+
+#include "vader/ColumnSelection.h"
+
 namespace mo {
 
+/// Only the columns selected by the optional ColumnSelection argument of the functions
+/// below are computed; by default, all of them are. The fields may be single or double
+/// precision, but must all have the same data type.
+
+/// \brief loads the svp lookup tables on the first task of comm and broadcasts them to
+/// the other tasks. Collective over comm: it must be called by all its tasks, outside
+/// parallel regions. Optional: without it, each task reads the file itself on the first
+/// call of evalSatVaporPressure.
+void loadSatVaporPressureTables(const eckit::mpi::Comm & comm = eckit::mpi::comm());
+
 /// \brief function to evaluate saturation water pressure (svp) [Pa]
 /// the Atlas field in the argument must contain an inizialised air temperature field
 /// and to have a defined svp field which is then calculated and returned as output
+/// It does not communicate, and can be called from concurrent threads.
 ///
-bool evalSatVaporPressure(atlas::FieldSet & fields);
+bool evalSatVaporPressure(atlas::FieldSet & fields,
+                          const vader::ColumnSelection & columns = vader::ColumnSelection());
 
 /// \brief function to evaluate saturation specific humidity (qsat)
 /// Needs air pressure [Pa] and svp [Pa] Atlas fields and returns the qsat Atlas field
-bool evalSatSpecificHumidity(atlas::FieldSet & fields);
+bool evalSatSpecificHumidity(atlas::FieldSet & fields,
+                             const vader::ColumnSelection & columns = vader::ColumnSelection());
 
 
 /// \brief function to evaluate the 'air_pressure_levels' from
@@ -33,7 +50,8 @@ bool evalSatSpecificHumidity(atlas::FieldSet & fields);
 /// except for the topmost level where the level is assumed to be in
 /// hydrostatic balance (and capped to be >0).
 ///
-bool evalAirPressureLevels(atlas::FieldSet & fields);
+bool evalAirPressureLevels(atlas::FieldSet & fields,
+                           const vader::ColumnSelection & columns = vader::ColumnSelection());
 
 
 }  // namespace mo
@@ -5,28 +5,40 @@
  * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
  */
 
+#include <Eigen/Core>
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include "mo/constants.h"
 #include "mo/control2analysis_linearvarchange.h"
 #include "mo/control2analysis_varchange.h"
+#include "mo/functions.h"
 
 #include "atlas/array/MakeView.h"
 
+#include "vader/StatsRegistry.h"
+
 using atlas::array::make_view;
 
 namespace mo {
 
+template <typename T>
 void thetavP2HexnerTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
-  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
-  const auto thetavView = make_view<const double, 2>(
+  vader::ScopedKernelTimer timer("mo::thetavP2HexnerTL");
+  timer.reads(augStateFlds, {"height_levels", "virtual_potential_temperature",
+                             "air_pressure_levels_minus_one", "hydrostatic_exner_levels"})
+       .reads(incFlds, {"virtual_potential_temperature", "air_pressure_levels_minus_one"})
+       .writes(incFlds, {"hydrostatic_exner_levels"});
+
+  const auto hlView = make_view<const T, 2>(augStateFlds["height_levels"]);
+  const auto thetavView = make_view<const T, 2>(
     augStateFlds["virtual_potential_temperature"]);
-  const auto pView = make_view<const double, 2>(augStateFlds["air_pressure_levels_minus_one"]);
-  const auto hexnerView = make_view<const double, 2>(augStateFlds["hydrostatic_exner_levels"]);
-  const auto thetavIncView = make_view<const double, 2>(incFlds["virtual_potential_temperature"]);
-  const auto pIncView = make_view<const double, 2>(incFlds["air_pressure_levels_minus_one"]);
-  auto hexnerIncView = make_view<double, 2>(incFlds["hydrostatic_exner_levels"]);
+  const auto pView = make_view<const T, 2>(augStateFlds["air_pressure_levels_minus_one"]);
+  const auto hexnerView = make_view<const T, 2>(augStateFlds["hydrostatic_exner_levels"]);
+  const auto thetavIncView = make_view<const T, 2>(incFlds["virtual_potential_temperature"]);
+  const auto pIncView = make_view<const T, 2>(incFlds["air_pressure_levels_minus_one"]);
+  auto hexnerIncView = make_view<T, 2>(incFlds["hydrostatic_exner_levels"]);
 
   for (atlas::idx_t jn = 0; jn < incFlds["hydrostatic_exner_levels"].shape(0); ++jn) {
     hexnerIncView(jn, 0) = constants::rd_over_cp *
@@ -41,15 +53,30 @@ void thetavP2HexnerTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStat
   }
 }
 
+void thetavP2HexnerTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(incFlds["hydrostatic_exner_levels"], [&](auto precision) {
+    return thetavP2HexnerTL<decltype(precision)>(incFlds, augStateFlds);
+  });
+}
+
+template <typename T>
 void thetavP2HexnerAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
-  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
-  const auto thetavView = make_view<const double, 2>(
+  vader::ScopedKernelTimer timer("mo::thetavP2HexnerAD");
+  timer.reads(augStateFlds, {"height_levels", "virtual_potential_temperature",
+                             "air_pressure_levels_minus_one", "hydrostatic_exner_levels"})
+       .reads(hatFlds, {"virtual_potential_temperature", "air_pressure_levels_minus_one",
+                        "hydrostatic_exner_levels"})
+       .writes(hatFlds, {"virtual_potential_temperature", "air_pressure_levels_minus_one",
+                         "hydrostatic_exner_levels"});
+
+  const auto hlView = make_view<const T, 2>(augStateFlds["height_levels"]);
+  const auto thetavView = make_view<const T, 2>(
     augStateFlds["virtual_potential_temperature"]);
-  const auto pView = make_view<const double, 2>(augStateFlds["air_pressure_levels_minus_one"]);
-  const auto hexnerView = make_view<const double, 2>(augStateFlds["hydrostatic_exner_levels"]);
-  auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
-  auto pHatView = make_view<double, 2>(hatFlds["air_pressure_levels_minus_one"]);
-  auto hexnerHatView = make_view<double, 2>(hatFlds["hydrostatic_exner_levels"]);
+  const auto pView = make_view<const T, 2>(augStateFlds["air_pressure_levels_minus_one"]);
+  const auto hexnerView = make_view<const T, 2>(augStateFlds["hydrostatic_exner_levels"]);
+  auto thetavHatView = make_view<T, 2>(hatFlds["virtual_potential_temperature"]);
+  auto pHatView = make_view<T, 2>(hatFlds["air_pressure_levels_minus_one"]);
+  auto hexnerHatView = make_view<T, 2>(hatFlds["hydrostatic_exner_levels"]);
 
   for (atlas::idx_t jn = 0; jn < hatFlds["hydrostatic_exner_levels"].shape(0); ++jn) {
     for (atlas::idx_t jl = hatFlds["hydrostatic_exner_levels"].levels() - 1; jl > 0; --jl) {
@@ -69,11 +96,23 @@ void thetavP2HexnerAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStat
   }
 }
 
+void thetavP2HexnerAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(hatFlds["virtual_potential_temperature"], [&](auto precision) {
+    return thetavP2HexnerAD<decltype(precision)>(hatFlds, augStateFlds);
+  });
+}
+
+template <typename T>
 void hexner2ThetavTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
-  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
-  const auto thetavView = make_view<const double, 2>(augStateFlds["virtual_potential_temperature"]);
-  const auto hexnerIncView = make_view<const double, 2>(incFlds["hydrostatic_exner_levels"]);
-  auto thetavIncView = make_view<double, 2>(incFlds["virtual_potential_temperature"]);
+  vader::ScopedKernelTimer timer("mo::hexner2ThetavTL");
+  timer.reads(augStateFlds, {"height_levels", "virtual_potential_temperature"})
+       .reads(incFlds, {"hydrostatic_exner_levels"})
+       .writes(incFlds, {"virtual_potential_temperature"});
+
+  const auto hlView = make_view<const T, 2>(augStateFlds["height_levels"]);
+  const auto thetavView = make_view<const T, 2>(augStateFlds["virtual_potential_temperature"]);
+  const auto hexnerIncView = make_view<const T, 2>(incFlds["hydrostatic_exner_levels"]);
+  auto thetavIncView = make_view<T, 2>(incFlds["virtual_potential_temperature"]);
 
   atlas::idx_t levels = incFlds["virtual_potential_temperature"].levels();
   for (atlas::idx_t jn = 0; jn < incFlds["virtual_potential_temperature"].shape(0); ++jn) {
@@ -86,11 +125,23 @@ void hexner2ThetavTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augState
   }
 }
 
+void hexner2ThetavTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(incFlds["virtual_potential_temperature"], [&](auto precision) {
+    return hexner2ThetavTL<decltype(precision)>(incFlds, augStateFlds);
+  });
+}
+
+template <typename T>
 void hexner2ThetavAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
-  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
-  const auto thetavView = make_view<const double, 2>(augStateFlds["virtual_potential_temperature"]);
-  auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
-  auto hexnerHatView = make_view<double, 2>(hatFlds["hydrostatic_exner_levels"]);
+  vader::ScopedKernelTimer timer("mo::hexner2ThetavAD");
+  timer.reads(augStateFlds, {"height_levels", "virtual_potential_temperature"})
+       .reads(hatFlds, {"virtual_potential_temperature", "hydrostatic_exner_levels"})
+       .writes(hatFlds, {"virtual_potential_temperature", "hydrostatic_exner_levels"});
+
+  const auto hlView = make_view<const T, 2>(augStateFlds["height_levels"]);
+  const auto thetavView = make_view<const T, 2>(augStateFlds["virtual_potential_temperature"]);
+  auto thetavHatView = make_view<T, 2>(hatFlds["virtual_potential_temperature"]);
+  auto hexnerHatView = make_view<T, 2>(hatFlds["hydrostatic_exner_levels"]);
 
   atlas::idx_t levelsm1 = hatFlds["virtual_potential_temperature"].levels()-1;
   for (atlas::idx_t jn = 0; jn < hatFlds["virtual_potential_temperature"].shape(0); ++jn) {
@@ -106,15 +157,28 @@ void hexner2ThetavAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState
   }
 }
 
+void hexner2ThetavAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(hatFlds["virtual_potential_temperature"], [&](auto precision) {
+    return hexner2ThetavAD<decltype(precision)>(hatFlds, augStateFlds);
+  });
+}
+
+template <typename T>
 void evalDryAirDensityTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
-  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
-  const auto hView = make_view<const double, 2>(augStateFlds["height"]);
-  const auto exnerView = make_view<const double, 2>(augStateFlds["exner_levels_minus_one"]);
-  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
-  const auto rhoView = make_view<const double, 2>(augStateFlds["dry_air_density_levels_minus_one"]);
-  const auto exnerIncView = make_view<const double, 2>(incFlds["exner_levels_minus_one"]);
-  const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
-  auto rhoIncView = make_view<double, 2>(incFlds["dry_air_density_levels_minus_one"]);
+  vader::ScopedKernelTimer timer("mo::evalDryAirDensityTL");
+  timer.reads(augStateFlds, {"height_levels", "height", "exner_levels_minus_one",
+                             "potential_temperature", "dry_air_density_levels_minus_one"})
+       .reads(incFlds, {"exner_levels_minus_one", "potential_temperature"})
+       .writes(incFlds, {"dry_air_density_levels_minus_one"});
+
+  const auto hlView = make_view<const T, 2>(augStateFlds["height_levels"]);
+  const auto hView = make_view<const T, 2>(augStateFlds["height"]);
+  const auto exnerView = make_view<const T, 2>(augStateFlds["exner_levels_minus_one"]);
+  const auto thetaView = make_view<const T, 2>(augStateFlds["potential_temperature"]);
+  const auto rhoView = make_view<const T, 2>(augStateFlds["dry_air_density_levels_minus_one"]);
+  const auto exnerIncView = make_view<const T, 2>(incFlds["exner_levels_minus_one"]);
+  const auto thetaIncView = make_view<const T, 2>(incFlds["potential_temperature"]);
+  auto rhoIncView = make_view<T, 2>(incFlds["dry_air_density_levels_minus_one"]);
 
   for (atlas::idx_t jn = 0; jn < rhoIncView.shape(0); ++jn) {
     for (atlas::idx_t jl = 1; jl < incFlds["dry_air_density_levels_minus_one"].levels(); ++jl) {
@@ -132,15 +196,30 @@ void evalDryAirDensityTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augS
   }
 }
 
+void evalDryAirDensityTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(incFlds["dry_air_density_levels_minus_one"], [&](auto precision) {
+    return evalDryAirDensityTL<decltype(precision)>(incFlds, augStateFlds);
+  });
+}
+
+template <typename T>
 void evalDryAirDensityAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
-  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
-  const auto hView = make_view<const double, 2>(augStateFlds["height"]);
-  const auto exnerView = make_view<const double, 2>(augStateFlds["exner_levels_minus_one"]);
-  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
-  const auto rhoView = make_view<const double, 2>(augStateFlds["dry_air_density_levels_minus_one"]);
-  auto exnerHatView = make_view<double, 2>(hatFlds["exner_levels_minus_one"]);
-  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
-  auto rhoHatView = make_view<double, 2>(hatFlds["dry_air_density_levels_minus_one"]);
+  vader::ScopedKernelTimer timer("mo::evalDryAirDensityAD");
+  timer.reads(augStateFlds, {"height_levels", "height", "exner_levels_minus_one",
+                             "potential_temperature", "dry_air_density_levels_minus_one"})
+       .reads(hatFlds, {"exner_levels_minus_one", "potential_temperature",
+                        "dry_air_density_levels_minus_one"})
+       .writes(hatFlds, {"exner_levels_minus_one", "potential_temperature",
+                         "dry_air_density_levels_minus_one"});
+
+  const auto hlView = make_view<const T, 2>(augStateFlds["height_levels"]);
+  const auto hView = make_view<const T, 2>(augStateFlds["height"]);
+  const auto exnerView = make_view<const T, 2>(augStateFlds["exner_levels_minus_one"]);
+  const auto thetaView = make_view<const T, 2>(augStateFlds["potential_temperature"]);
+  const auto rhoView = make_view<const T, 2>(augStateFlds["dry_air_density_levels_minus_one"]);
+  auto exnerHatView = make_view<T, 2>(hatFlds["exner_levels_minus_one"]);
+  auto thetaHatView = make_view<T, 2>(hatFlds["potential_temperature"]);
+  auto rhoHatView = make_view<T, 2>(hatFlds["dry_air_density_levels_minus_one"]);
 
   for (atlas::idx_t jn = 0; jn < rhoHatView.shape(0); ++jn) {
     exnerHatView(jn, 0) += rhoView(jn, 0) * rhoHatView(jn, 0) /
@@ -165,16 +244,29 @@ void evalDryAirDensityAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augS
   }
 }
 
+void evalDryAirDensityAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(hatFlds["exner_levels_minus_one"], [&](auto precision) {
+    return evalDryAirDensityAD<decltype(precision)>(hatFlds, augStateFlds);
+  });
+}
+
 
 /// \details This calculates air temperature increments.
+template <typename T>
 void evalAirTemperatureTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
-  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
-  const auto hView = make_view<const double, 2>(augStateFlds["height"]);
-  const auto exnerLevelsView = make_view<const double, 2>(augStateFlds["exner_levels_minus_one"]);
-  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
-  const auto exnerLevelsIncView = make_view<const double, 2>(incFlds["exner_levels_minus_one"]);
-  const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
-  auto tIncView = make_view<double, 2>(incFlds["air_temperature"]);
+  vader::ScopedKernelTimer timer("mo::evalAirTemperatureTL");
+  timer.reads(augStateFlds, {"height_levels", "height", "exner_levels_minus_one",
+                             "potential_temperature"})
+       .reads(incFlds, {"exner_levels_minus_one", "potential_temperature"})
+       .writes(incFlds, {"air_temperature"});
+
+  const auto hlView = make_view<const T, 2>(augStateFlds["height_levels"]);
+  const auto hView = make_view<const T, 2>(augStateFlds["height"]);
+  const auto exnerLevelsView = make_view<const T, 2>(augStateFlds["exner_levels_minus_one"]);
+  const auto thetaView = make_view<const T, 2>(augStateFlds["potential_temperature"]);
+  const auto exnerLevelsIncView = make_view<const T, 2>(incFlds["exner_levels_minus_one"]);
+  const auto thetaIncView = make_view<const T, 2>(incFlds["potential_temperature"]);
+  auto tIncView = make_view<T, 2>(incFlds["air_temperature"]);
 
   atlas::idx_t lvls(incFlds["air_temperature"].levels());
   atlas::idx_t lvlsm1 = lvls - 1;
@@ -215,16 +307,29 @@ void evalAirTemperatureTL(atlas::FieldSet & incFlds, const atlas::FieldSet & aug
   }
 }
 
+void evalAirTemperatureTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(incFlds["air_temperature"], [&](auto precision) {
+    return evalAirTemperatureTL<decltype(precision)>(incFlds, augStateFlds);
+  });
+}
+
 
 /// \details This calculates air temperature increments.
+template <typename T>
 void evalAirTemperatureAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
-  const auto hlView = make_view<const double, 2>(augStateFlds["height_levels"]);
-  const auto hView = make_view<const double, 2>(augStateFlds["height"]);
-  const auto exnerLevelsView = make_view<const double, 2>(augStateFlds["exner_levels_minus_one"]);
-  const auto thetaView = make_view<const double, 2>(augStateFlds["potential_temperature"]);
-  auto exnerLevelsHatView = make_view<double, 2>(hatFlds["exner_levels_minus_one"]);
-  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
-  auto tHatView = make_view<double, 2>(hatFlds["air_temperature"]);
+  vader::ScopedKernelTimer timer("mo::evalAirTemperatureAD");
+  timer.reads(augStateFlds, {"height_levels", "height", "exner_levels_minus_one",
+                             "potential_temperature"})
+       .reads(hatFlds, {"exner_levels_minus_one", "potential_temperature", "air_temperature"})
+       .writes(hatFlds, {"exner_levels_minus_one", "potential_temperature", "air_temperature"});
+
+  const auto hlView = make_view<const T, 2>(augStateFlds["height_levels"]);
+  const auto hView = make_view<const T, 2>(augStateFlds["height"]);
+  const auto exnerLevelsView = make_view<const T, 2>(augStateFlds["exner_levels_minus_one"]);
+  const auto thetaView = make_view<const T, 2>(augStateFlds["potential_temperature"]);
+  auto exnerLevelsHatView = make_view<T, 2>(hatFlds["exner_levels_minus_one"]);
+  auto thetaHatView = make_view<T, 2>(hatFlds["potential_temperature"]);
+  auto tHatView = make_view<T, 2>(hatFlds["air_temperature"]);
 
   atlas::idx_t lvls(hatFlds["air_temperature"].levels());
   atlas::idx_t lvlsm1 = lvls - 1;
@@ -280,18 +385,33 @@ void evalAirTemperatureAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & aug
   }
 }
 
+void evalAirTemperatureAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(hatFlds["exner_levels_minus_one"], [&](auto precision) {
+    return evalAirTemperatureAD<decltype(precision)>(hatFlds, augStateFlds);
+  });
+}
+
 
 void qqclqcf2qtTL(atlas::FieldSet & incFields, const atlas::FieldSet &) {
   qqclqcf2qt(incFields);
 }
 
+template <typename T>
 void qqclqcf2qtAD(atlas::FieldSet & hatFields, const atlas::FieldSet &) {
-  auto qHatView = make_view<double, 2>(hatFields["specific_humidity"]);
-  auto qclHatView = make_view<double, 2>
+  vader::ScopedKernelTimer timer("mo::qqclqcf2qtAD");
+  timer.reads(hatFields, {"specific_humidity",
+                          "mass_content_of_cloud_liquid_water_in_atmosphere_layer",
+                          "mass_content_of_cloud_ice_in_atmosphere_layer", "qt"})
+       .writes(hatFields, {"specific_humidity",
+                           "mass_content_of_cloud_liquid_water_in_atmosphere_layer",
+                           "mass_content_of_cloud_ice_in_atmosphere_layer", "qt"});
+
+  auto qHatView = make_view<T, 2>(hatFields["specific_humidity"]);
+  auto qclHatView = make_view<T, 2>
                     (hatFields["mass_content_of_cloud_liquid_water_in_atmosphere_layer"]);
-  auto qcfHatView = make_view<double, 2>
+  auto qcfHatView = make_view<T, 2>
                     (hatFields["mass_content_of_cloud_ice_in_atmosphere_layer"]);
-  auto qtHatView = make_view<double, 2>(hatFields["qt"]);
+  auto qtHatView = make_view<T, 2>(hatFields["qt"]);
 
   for (atlas::idx_t jn = 0; jn < hatFields["qt"].shape(0); ++jn) {
     for (atlas::idx_t jl = 0; jl < hatFields["qt"].levels(); ++jl) {
@@ -303,20 +423,33 @@ void qqclqcf2qtAD(atlas::FieldSet & hatFields, const atlas::FieldSet &) {
   }
 }
 
+void qqclqcf2qtAD(atlas::FieldSet & hatFields, const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(hatFields["specific_humidity"], [&](auto precision) {
+    return qqclqcf2qtAD<decltype(precision)>(hatFields, augStateFlds);
+  });
+}
+
+template <typename T>
 void qtTemperature2qqclqcfTL(atlas::FieldSet & incFlds,
                              const atlas::FieldSet & augStateFlds) {
-  const auto qsatView = make_view<const double, 2>(augStateFlds["qsat"]);
-  const auto dlsvpdTView = make_view<const double, 2>(augStateFlds["dlsvpdT"]);
-  const auto cleffView = make_view<const double, 2>(augStateFlds["cleff"]);
-  const auto cfeffView = make_view<const double, 2>(augStateFlds["cfeff"]);
-
-  const auto qtIncView = make_view<const double, 2>(incFlds["qt"]);
-  const auto temperIncView = make_view<const double, 2>(incFlds["air_temperature"]);
-  auto qclIncView = make_view<double, 2>
+  vader::ScopedKernelTimer timer("mo::qtTemperature2qqclqcfTL");
+  timer.reads(augStateFlds, {"qsat", "dlsvpdT", "cleff", "cfeff"})
+       .reads(incFlds, {"qt", "air_temperature"})
+       .writes(incFlds, {"mass_content_of_cloud_liquid_water_in_atmosphere_layer",
+                         "mass_content_of_cloud_ice_in_atmosphere_layer", "specific_humidity"});
+
+  const auto qsatView = make_view<const T, 2>(augStateFlds["qsat"]);
+  const auto dlsvpdTView = make_view<const T, 2>(augStateFlds["dlsvpdT"]);
+  const auto cleffView = make_view<const T, 2>(augStateFlds["cleff"]);
+  const auto cfeffView = make_view<const T, 2>(augStateFlds["cfeff"]);
+
+  const auto qtIncView = make_view<const T, 2>(incFlds["qt"]);
+  const auto temperIncView = make_view<const T, 2>(incFlds["air_temperature"]);
+  auto qclIncView = make_view<T, 2>
                     (incFlds["mass_content_of_cloud_liquid_water_in_atmosphere_layer"]);
-  auto qcfIncView = make_view<double, 2>
+  auto qcfIncView = make_view<T, 2>
                     (incFlds["mass_content_of_cloud_ice_in_atmosphere_layer"]);
-  auto qIncView = make_view<double, 2>(incFlds["specific_humidity"]);
+  auto qIncView = make_view<T, 2>(incFlds["specific_humidity"]);
 
 
   double maxCldInc;
@@ -331,19 +464,37 @@ void qtTemperature2qqclqcfTL(atlas::FieldSet & incFlds,
   }
 }
 
+void qtTemperature2qqclqcfTL(atlas::FieldSet & incFlds,
+                             const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(
+      incFlds["mass_content_of_cloud_liquid_water_in_atmosphere_layer"], [&](auto precision) {
+    return qtTemperature2qqclqcfTL<decltype(precision)>(incFlds, augStateFlds);
+  });
+}
+
+template <typename T>
 void qtTemperature2qqclqcfAD(atlas::FieldSet & hatFlds,
                              const atlas::FieldSet & augStateFlds) {
-  const auto qsatView = make_view<const double, 2>(augStateFlds["qsat"]);
-  const auto dlsvpdTView = make_view<const double, 2>(augStateFlds["dlsvpdT"]);
-  const auto cleffView = make_view<const double, 2>(augStateFlds["cleff"]);
-  const auto cfeffView = make_view<const double, 2>(augStateFlds["cfeff"]);
-
-  auto temperHatView = make_view<double, 2>(hatFlds["air_temperature"]);
-  auto qtHatView = make_view<double, 2>(hatFlds["qt"]);
-  auto qHatView = make_view<double, 2>(hatFlds["specific_humidity"]);
-  auto qclHatView = make_view<double, 2>
+  vader::ScopedKernelTimer timer("mo::qtTemperature2qqclqcfAD");
+  timer.reads(augStateFlds, {"qsat", "dlsvpdT", "cleff", "cfeff"})
+       .reads(hatFlds, {"air_temperature", "qt", "specific_humidity",
+                        "mass_content_of_cloud_liquid_water_in_atmosphere_layer",
+                        "mass_content_of_cloud_ice_in_atmosphere_layer"})
+       .writes(hatFlds, {"air_temperature", "qt", "specific_humidity",
+                         "mass_content_of_cloud_liquid_water_in_atmosphere_layer",
+                         "mass_content_of_cloud_ice_in_atmosphere_layer"});
+
+  const auto qsatView = make_view<const T, 2>(augStateFlds["qsat"]);
+  const auto dlsvpdTView = make_view<const T, 2>(augStateFlds["dlsvpdT"]);
+  const auto cleffView = make_view<const T, 2>(augStateFlds["cleff"]);
+  const auto cfeffView = make_view<const T, 2>(augStateFlds["cfeff"]);
+
+  auto temperHatView = make_view<T, 2>(hatFlds["air_temperature"]);
+  auto qtHatView = make_view<T, 2>(hatFlds["qt"]);
+  auto qHatView = make_view<T, 2>(hatFlds["specific_humidity"]);
+  auto qclHatView = make_view<T, 2>
                     (hatFlds["mass_content_of_cloud_liquid_water_in_atmosphere_layer"]);
-  auto qcfHatView = make_view<double, 2>
+  auto qcfHatView = make_view<T, 2>
                     (hatFlds["mass_content_of_cloud_ice_in_atmosphere_layer"]);
 
   double qsatdlsvpdT;
@@ -364,15 +515,88 @@ void qtTemperature2qqclqcfAD(atlas::FieldSet & hatFlds,
   }
 }
 
+void qtTemperature2qqclqcfAD(atlas::FieldSet & hatFlds,
+                             const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(hatFlds["air_temperature"], [&](auto precision) {
+    return qtTemperature2qqclqcfAD<decltype(precision)>(hatFlds, augStateFlds);
+  });
+}
+
+
+namespace {
+
+/// \brief columns to which the vertical regression matrix of one bin applies, processed
+///        together as one matrix-matrix product
+struct RegressionBlock {
+  atlas::idx_t bin;
+  std::vector<atlas::idx_t> columns;
+};
+
+/// \brief maximum number of columns in a RegressionBlock
+const std::size_t regressionBlockSize = 1024;
+
+/// \brief groups the columns by the bin whose vertical regression matrix applies to them,
+///        in blocks of at most regressionBlockSize columns. That is the last bin with an
+///        interpolation weight above __FLT_EPSILON__: the hydrostatic pressure increment
+///        is reset for each such bin, so only the last one contributes. Columns without
+///        such a bin are in no block.
+template <typename WeightView>
+std::vector<RegressionBlock> groupColumnsByBin(const WeightView & interpWeightView,
+                                               const atlas::idx_t ncolumns,
+                                               const atlas::idx_t nBins) {
+  std::vector<std::vector<atlas::idx_t>> binColumns(nBins);
+  for (atlas::idx_t jn = 0; jn < ncolumns; ++jn) {
+    for (atlas::idx_t b = nBins - 1; b >= 0; --b) {
+      if (interpWeightView(jn, b) > __FLT_EPSILON__) {
+        binColumns[b].push_back(jn);
+        break;
+      }
+    }
+  }
+  std::vector<RegressionBlock> blocks;
+  for (atlas::idx_t b = 0; b < nBins; ++b) {
+    for (std::size_t first = 0; first < binColumns[b].size(); first += regressionBlockSize) {
+      const std::size_t last = std::min(first + regressionBlockSize, binColumns[b].size());
+      blocks.push_back(RegressionBlock{b, std::vector<atlas::idx_t>(
+        binColumns[b].begin() + first, binColumns[b].begin() + last)});
+    }
+  }
+  return blocks;
+}
 
+/// \brief vertical regression matrix of one bin, read in place from the field holding
+///        them one below the other (whatever the strides of its view)
+typedef Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>,
+                   Eigen::Unaligned, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>
+  RegressionMatrix;
+
+template <typename RegressionView>
+RegressionMatrix regressionMatrix(const RegressionView & vertRegView,
+                                  const atlas::idx_t levels,
+                                  const atlas::idx_t bin) {
+  return RegressionMatrix(&vertRegView(bin * levels, 0), levels, levels,
+                          Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(
+                            vertRegView.stride(0), vertRegView.stride(1)));
+}
+
+}  // namespace
+
+template <typename T>
 void evalHydrostaticPressureTL(atlas::FieldSet & incFlds,
                                const atlas::FieldSet & augStateFlds) {
-  const auto gPIncView = make_view<const double, 2>(
+  vader::ScopedKernelTimer timer("mo::evalHydrostaticPressureTL");
+  timer.reads(augStateFlds, {"air_pressure_levels", "interpolation_weights",
+                             "vertical_regression_matrices"})
+       .reads(incFlds, {"geostrophic_pressure_levels_minus_one",
+                        "unbalanced_pressure_levels_minus_one"})
+       .writes(incFlds, {"hydrostatic_pressure_levels"});
+
+  const auto gPIncView = make_view<const T, 2>(
     incFlds["geostrophic_pressure_levels_minus_one"]);
-  const auto uPIncView = make_view<const double, 2>(
+  const auto uPIncView = make_view<const T, 2>(
     incFlds["unbalanced_pressure_levels_minus_one"]);
 
-  const auto pView = make_view<const double, 2>(augStateFlds["air_pressure_levels"]);
+  const auto pView = make_view<const T, 2>(augStateFlds["air_pressure_levels"]);
   // First index of interpWeightView is horizontal index, the second is bin index here
   const auto interpWeightView = make_view<const double, 2>(augStateFlds["interpolation_weights"]);
 
@@ -386,38 +610,68 @@ void evalHydrostaticPressureTL(atlas::FieldSet & incFlds,
   //     the second is number of levels associated with matrix column.
   const auto vertRegView = make_view<const double, 2>(augStateFlds["vertical_regression_matrices"]);
 
-  auto hPIncView = make_view<double, 2>(incFlds["hydrostatic_pressure_levels"]);
+  auto hPIncView = make_view<T, 2>(incFlds["hydrostatic_pressure_levels"]);
 
   atlas::idx_t levels = incFlds["geostrophic_pressure_levels_minus_one"].levels();
   atlas::idx_t nBins = augStateFlds["interpolation_weights"].shape(1);
-
-  for (atlas::idx_t jn = 0; jn < incFlds["hydrostatic_pressure_levels"].shape(0); ++jn) {
-    for (atlas::idx_t b = 0; b < nBins; ++b) {
-      if (interpWeightView(jn , b) > __FLT_EPSILON__) {
-        for (atlas::idx_t jl = 0; jl < levels; ++jl) {
-          hPIncView(jn, jl) = uPIncView(jn, jl);
-          for (atlas::idx_t jl2 = 0; jl2 < levels; ++jl2) {
-            hPIncView(jn, jl) +=
-                                 interpWeightView(jn, b) *
-                                 vertRegView(b * levels + jl, jl2) *
-                                 gPIncView(jn, jl2);
-          }
-        }
+  const atlas::idx_t ncolumns = incFlds["hydrostatic_pressure_levels"].shape(0);
+
+  // For the columns of each block, with the regression matrix R of their bin:
+  // hPInc = uPInc + weight * R gPInc, computed for the whole block as R (gPInc ...)
+  const std::vector<RegressionBlock> blocks = groupColumnsByBin(interpWeightView, ncolumns,
+                                                                nBins);
+
+#pragma omp parallel for schedule(dynamic)
+  for (std::size_t jb = 0; jb < blocks.size(); ++jb) {
+    const RegressionBlock & block = blocks[jb];
+    const atlas::idx_t ncols = static_cast<atlas::idx_t>(block.columns.size());
+    Eigen::MatrixXd gPInc(levels, ncols);
+    for (atlas::idx_t k = 0; k < ncols; ++k) {
+      for (atlas::idx_t jl = 0; jl < levels; ++jl) {
+        gPInc(jl, k) = gPIncView(block.columns[k], jl);
+      }
+    }
+    const Eigen::MatrixXd regressed = regressionMatrix(vertRegView, levels, block.bin) * gPInc;
+    for (atlas::idx_t k = 0; k < ncols; ++k) {
+      const atlas::idx_t jn = block.columns[k];
+      const double weight = interpWeightView(jn, block.bin);
+      for (atlas::idx_t jl = 0; jl < levels; ++jl) {
+        hPIncView(jn, jl) = uPIncView(jn, jl) + weight * regressed(jl, k);
       }
     }
+  }
+
+#pragma omp parallel for schedule(static)
+  for (atlas::idx_t jn = 0; jn < ncolumns; ++jn) {
     hPIncView(jn, levels) =
       hPIncView(jn, levels-1) *
       std::pow(pView(jn, levels-1) / pView(jn, levels), constants::rd_over_cp - 1.0);
   }
 }
 
+void evalHydrostaticPressureTL(atlas::FieldSet & incFlds,
+                               const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(incFlds["hydrostatic_pressure_levels"], [&](auto precision) {
+    return evalHydrostaticPressureTL<decltype(precision)>(incFlds, augStateFlds);
+  });
+}
+
 
+template <typename T>
 void evalHydrostaticPressureAD(atlas::FieldSet & hatFlds,
                                const atlas::FieldSet & augStateFlds) {
-  auto gpHatView = make_view<double, 2>(hatFlds["geostrophic_pressure_levels_minus_one"]);
-  auto uPHatView = make_view<double, 2>(hatFlds["unbalanced_pressure_levels_minus_one"]);
-
-  const auto pView = make_view<const double, 2>(augStateFlds["air_pressure_levels"]);
+  vader::ScopedKernelTimer timer("mo::evalHydrostaticPressureAD");
+  timer.reads(augStateFlds, {"air_pressure_levels", "interpolation_weights",
+                             "vertical_regression_matrices"})
+       .reads(hatFlds, {"geostrophic_pressure_levels_minus_one",
+                        "unbalanced_pressure_levels_minus_one", "hydrostatic_pressure_levels"})
+       .writes(hatFlds, {"geostrophic_pressure_levels_minus_one",
+                         "unbalanced_pressure_levels_minus_one", "hydrostatic_pressure_levels"});
+
+  auto gpHatView = make_view<T, 2>(hatFlds["geostrophic_pressure_levels_minus_one"]);
+  auto uPHatView = make_view<T, 2>(hatFlds["unbalanced_pressure_levels_minus_one"]);
+
+  const auto pView = make_view<const T, 2>(augStateFlds["air_pressure_levels"]);
   // First index of interpWeightView is horizontal index, the second is bin index here
   const auto interpWeightView = make_view<const double, 2>(augStateFlds["interpolation_weights"]);
 
@@ -431,41 +685,71 @@ void evalHydrostaticPressureAD(atlas::FieldSet & hatFlds,
   //     the second is level index
   const auto vertRegView = make_view<const double, 2>(augStateFlds["vertical_regression_matrices"]);
 
-  auto hPHatView = make_view<double, 2>(hatFlds["hydrostatic_pressure_levels"]);
+  auto hPHatView = make_view<T, 2>(hatFlds["hydrostatic_pressure_levels"]);
 
   atlas::idx_t levels = hatFlds["geostrophic_pressure_levels_minus_one"].levels();
   atlas::idx_t nBins = augStateFlds["vertical_regression_matrices"].shape(0) / levels;
+  const atlas::idx_t ncolumns = hatFlds["hydrostatic_pressure_levels"].shape(0);
 
-  for (atlas::idx_t jn = 0; jn < hatFlds["hydrostatic_pressure_levels"].shape(0); ++jn) {
+#pragma omp parallel for schedule(static)
+  for (atlas::idx_t jn = 0; jn < ncolumns; ++jn) {
     hPHatView(jn, levels - 1) +=
      hPHatView(jn, levels) *
      std::pow(pView(jn, levels-1) / pView(jn, levels), constants::rd_over_cp - 1.0);
     hPHatView(jn, levels) = 0.0;
+  }
 
-    for (atlas::idx_t b = nBins -1; b >= 0; --b) {
-      if (interpWeightView(jn , b) > __FLT_EPSILON__) {
-        for (atlas::idx_t jl = levels - 1; jl >= 0; --jl) {
-          for (atlas::idx_t jl2 = levels - 1; jl2 >= 0; --jl2) {
-            gpHatView(jn, jl2) +=
-                                  interpWeightView(jn, b) *
-                                  vertRegView(b * levels + jl, jl2) *
-                                  hPHatView(jn, jl);
-          }
-          uPHatView(jn, jl) += hPHatView(jn, jl);
-          hPHatView(jn, jl) = 0.0;
-        }
+  // Adjoint of the tangent linear, with the transposed regression matrix R of the bin
+  // of each block: gpHat += R^T (weight * hPHat ...), uPHat += hPHat, hPHat = 0
+  const std::vector<RegressionBlock> blocks = groupColumnsByBin(interpWeightView, ncolumns,
+                                                                nBins);
+
+#pragma omp parallel for schedule(dynamic)
+  for (std::size_t jb = 0; jb < blocks.size(); ++jb) {
+    const RegressionBlock & block = blocks[jb];
+    const atlas::idx_t ncols = static_cast<atlas::idx_t>(block.columns.size());
+    Eigen::MatrixXd hPHat(levels, ncols);
+    for (atlas::idx_t k = 0; k < ncols; ++k) {
+      const atlas::idx_t jn = block.columns[k];
+      const double weight = interpWeightView(jn, block.bin);
+      for (atlas::idx_t jl = 0; jl < levels; ++jl) {
+        hPHat(jl, k) = weight * hPHatView(jn, jl);
+      }
+    }
+    const Eigen::MatrixXd gpHat =
+      regressionMatrix(vertRegView, levels, block.bin).transpose() * hPHat;
+    for (atlas::idx_t k = 0; k < ncols; ++k) {
+      const atlas::idx_t jn = block.columns[k];
+      for (atlas::idx_t jl = 0; jl < levels; ++jl) {
+        gpHatView(jn, jl) += gpHat(jl, k);
+        uPHatView(jn, jl) += hPHatView(jn, jl);
+        hPHatView(jn, jl) = 0.0;
       }
     }
   }
 }
 
+void evalHydrostaticPressureAD(atlas::FieldSet & hatFlds,
+                               const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(
+      hatFlds["geostrophic_pressure_levels_minus_one"], [&](auto precision) {
+    return evalHydrostaticPressureAD<decltype(precision)>(hatFlds, augStateFlds);
+  });
+}
+
 /// \details This calculates the hydrostatic exner field from the hydrostatic pressure
+template <typename T>
 void evalHydrostaticExnerTL(atlas::FieldSet & incFlds,
                             const atlas::FieldSet & augStateFlds) {
-  const auto pView = make_view<const double, 2>(augStateFlds["hydrostatic_pressure_levels"]);
-  const auto exnerView = make_view<const double, 2>(augStateFlds["hydrostatic_exner_levels"]);
-  const auto pIncView = make_view<const double, 2>(incFlds["hydrostatic_pressure_levels"]);
-  auto exnerIncView = make_view<double, 2>(incFlds["hydrostatic_exner_levels"]);
+  vader::ScopedKernelTimer timer("mo::evalHydrostaticExnerTL");
+  timer.reads(augStateFlds, {"hydrostatic_pressure_levels", "hydrostatic_exner_levels"})
+       .reads(incFlds, {"hydrostatic_pressure_levels"})
+       .writes(incFlds, {"hydrostatic_exner_levels"});
+
+  const auto pView = make_view<const T, 2>(augStateFlds["hydrostatic_pressure_levels"]);
+  const auto exnerView = make_view<const T, 2>(augStateFlds["hydrostatic_exner_levels"]);
+  const auto pIncView = make_view<const T, 2>(incFlds["hydrostatic_pressure_levels"]);
+  auto exnerIncView = make_view<T, 2>(incFlds["hydrostatic_exner_levels"]);
 
   atlas::idx_t levels = incFlds["hydrostatic_exner_levels"].levels();
   for (atlas::idx_t jn = 0; jn < incFlds["hydrostatic_exner_levels"].shape(0); ++jn) {
@@ -477,13 +761,26 @@ void evalHydrostaticExnerTL(atlas::FieldSet & incFlds,
   }
 }
 
+void evalHydrostaticExnerTL(atlas::FieldSet & incFlds,
+                            const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(incFlds["hydrostatic_exner_levels"], [&](auto precision) {
+    return evalHydrostaticExnerTL<decltype(precision)>(incFlds, augStateFlds);
+  });
+}
+
 /// \details This is the adjoint of the calculation of hydrostatic exner increments
+template <typename T>
 void evalHydrostaticExnerAD(atlas::FieldSet & hatFlds,
                             const atlas::FieldSet & augStateFlds) {
-  const auto pView = make_view<const double, 2>(augStateFlds["hydrostatic_pressure_levels"]);
-  const auto exnerView = make_view<const double, 2>(augStateFlds["hydrostatic_exner_levels"]);
-  auto pHatView = make_view<double, 2>(hatFlds["hydrostatic_pressure_levels"]);
-  auto exnerHatView = make_view<double, 2>(hatFlds["hydrostatic_exner_levels"]);
+  vader::ScopedKernelTimer timer("mo::evalHydrostaticExnerAD");
+  timer.reads(augStateFlds, {"hydrostatic_pressure_levels", "hydrostatic_exner_levels"})
+       .reads(hatFlds, {"hydrostatic_pressure_levels", "hydrostatic_exner_levels"})
+       .writes(hatFlds, {"hydrostatic_pressure_levels", "hydrostatic_exner_levels"});
+
+  const auto pView = make_view<const T, 2>(augStateFlds["hydrostatic_pressure_levels"]);
+  const auto exnerView = make_view<const T, 2>(augStateFlds["hydrostatic_exner_levels"]);
+  auto pHatView = make_view<T, 2>(hatFlds["hydrostatic_pressure_levels"]);
+  auto exnerHatView = make_view<T, 2>(hatFlds["hydrostatic_exner_levels"]);
 
   atlas::idx_t levels = hatFlds["hydrostatic_exner_levels"].levels();
   for (atlas::idx_t jn = 0; jn < hatFlds["hydrostatic_exner_levels"].shape(0); ++jn) {
@@ -496,21 +793,34 @@ void evalHydrostaticExnerAD(atlas::FieldSet & hatFlds,
   }
 }
 
+void evalHydrostaticExnerAD(atlas::FieldSet & hatFlds,
+                            const atlas::FieldSet & augStateFlds) {
+  functions::dispatchPrecision(hatFlds["hydrostatic_pressure_levels"], [&](auto precision) {
+    return evalHydrostaticExnerAD<decltype(precision)>(hatFlds, augStateFlds);
+  });
+}
+
 
 /// \details This is function calculates the linear moisture
 ///          control variable (muInc and thetavInc) from (thetaInc) and (qtInc)
 ///          We are ignoring the scaled pressure contribution to mu, because we have
 ///          found in the past that it gives no benefit and that its contribution
 ///          is small.
+template <typename T>
 void evalMuThetavTL(atlas::FieldSet & incFlds,  const atlas::FieldSet & augState) {
-  const auto muRow1Column1View = make_view<const double, 2>(augState["muRow1Column1"]);
-  const auto muRow1Column2View = make_view<const double, 2>(augState["muRow1Column2"]);
-  const auto muRow2Column1View = make_view<const double, 2>(augState["muRow2Column1"]);
-  const auto muRow2Column2View = make_view<const double, 2>(augState["muRow2Column2"]);
-  const auto thetaIncView = make_view<const double, 2>(incFlds["potential_temperature"]);
-  const auto qtIncView = make_view<const double, 2>(incFlds["qt"]);
-  auto muIncView = make_view<double, 2>(incFlds["mu"]);
-  auto thetavIncView = make_view<double, 2>(incFlds["virtual_potential_temperature"]);
+  vader::ScopedKernelTimer timer("mo::evalMuThetavTL");
+  timer.reads(augState, {"muRow1Column1", "muRow1Column2", "muRow2Column1", "muRow2Column2"})
+       .reads(incFlds, {"potential_temperature", "qt"})
+       .writes(incFlds, {"mu", "virtual_potential_temperature"});
+
+  const auto muRow1Column1View = make_view<const T, 2>(augState["muRow1Column1"]);
+  const auto muRow1Column2View = make_view<const T, 2>(augState["muRow1Column2"]);
+  const auto muRow2Column1View = make_view<const T, 2>(augState["muRow2Column1"]);
+  const auto muRow2Column2View = make_view<const T, 2>(augState["muRow2Column2"]);
+  const auto thetaIncView = make_view<const T, 2>(incFlds["potential_temperature"]);
+  const auto qtIncView = make_view<const T, 2>(incFlds["qt"]);
+  auto muIncView = make_view<T, 2>(incFlds["mu"]);
+  auto thetavIncView = make_view<T, 2>(incFlds["virtual_potential_temperature"]);
 
   for (atlas::idx_t jn = 0; jn < incFlds["mu"].shape(0); ++jn) {
     for (atlas::idx_t jl = 0; jl < incFlds["mu"].levels(); ++jl) {
@@ -522,16 +832,28 @@ void evalMuThetavTL(atlas::FieldSet & incFlds,  const atlas::FieldSet & augState
   }
 }
 
+void evalMuThetavTL(atlas::FieldSet & incFlds,  const atlas::FieldSet & augState) {
+  functions::dispatchPrecision(incFlds["mu"], [&](auto precision) {
+    return evalMuThetavTL<decltype(precision)>(incFlds, augState);
+  });
+}
+
 
+template <typename T>
 void evalMuThetavAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState) {
-  const auto muRow1Column1View = make_view<const double, 2>(augState["muRow1Column1"]);
-  const auto muRow1Column2View = make_view<const double, 2>(augState["muRow1Column2"]);
-  const auto muRow2Column1View = make_view<const double, 2>(augState["muRow2Column1"]);
-  const auto muRow2Column2View = make_view<const double, 2>(augState["muRow2Column2"]);
-  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
-  auto qtHatView = make_view<double, 2>(hatFlds["qt"]);
-  auto muHatView = make_view<double, 2>(hatFlds["mu"]);
-  auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
+  vader::ScopedKernelTimer timer("mo::evalMuThetavAD");
+  timer.reads(augState, {"muRow1Column1", "muRow1Column2", "muRow2Column1", "muRow2Column2"})
+       .reads(hatFlds, {"potential_temperature", "qt", "mu", "virtual_potential_temperature"})
+       .writes(hatFlds, {"potential_temperature", "qt", "mu", "virtual_potential_temperature"});
+
+  const auto muRow1Column1View = make_view<const T, 2>(augState["muRow1Column1"]);
+  const auto muRow1Column2View = make_view<const T, 2>(augState["muRow1Column2"]);
+  const auto muRow2Column1View = make_view<const T, 2>(augState["muRow2Column1"]);
+  const auto muRow2Column2View = make_view<const T, 2>(augState["muRow2Column2"]);
+  auto thetaHatView = make_view<T, 2>(hatFlds["potential_temperature"]);
+  auto qtHatView = make_view<T, 2>(hatFlds["qt"]);
+  auto muHatView = make_view<T, 2>(hatFlds["mu"]);
+  auto thetavHatView = make_view<T, 2>(hatFlds["virtual_potential_temperature"]);
 
   for (atlas::idx_t jn = 0; jn < hatFlds["mu"].shape(0); ++jn) {
     for (atlas::idx_t jl = 0; jl < hatFlds["mu"].levels(); ++jl) {
@@ -545,18 +867,31 @@ void evalMuThetavAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState)
   }
 }
 
+void evalMuThetavAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState) {
+  functions::dispatchPrecision(hatFlds["potential_temperature"], [&](auto precision) {
+    return evalMuThetavAD<decltype(precision)>(hatFlds, augState);
+  });
+}
+
 
+template <typename T>
 void evalQtThetaTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augState) {
+  vader::ScopedKernelTimer timer("mo::evalQtThetaTL");
+  timer.reads(augState, {"muRecipDeterminant", "muRow1Column1", "muRow1Column2", "muRow2Column1",
+                         "muRow2Column2"})
+       .reads(incFlds, {"mu", "virtual_potential_temperature"})
+       .writes(incFlds, {"qt", "potential_temperature"});
+
   // Using Cramer's rule to calculate inverse.
-  const auto muRecipDeterView = make_view<const double, 2>(augState["muRecipDeterminant"]);
-  const auto muRow1Column1View = make_view<const double, 2>(augState["muRow1Column1"]);
-  const auto muRow1Column2View = make_view<const double, 2>(augState["muRow1Column2"]);
-  const auto muRow2Column1View = make_view<const double, 2>(augState["muRow2Column1"]);
-  const auto muRow2Column2View  = make_view<const double, 2>(augState["muRow2Column2"]);
-  const auto muIncView = make_view<const double, 2>(incFlds["mu"]);
-  const auto thetavIncView = make_view<const double, 2>(incFlds["virtual_potential_temperature"]);
-  auto qtIncView = make_view<double, 2>(incFlds["qt"]);
-  auto thetaIncView = make_view<double, 2>(incFlds["potential_temperature"]);
+  const auto muRecipDeterView = make_view<const T, 2>(augState["muRecipDeterminant"]);
+  const auto muRow1Column1View = make_view<const T, 2>(augState["muRow1Column1"]);
+  const auto muRow1Column2View = make_view<const T, 2>(augState["muRow1Column2"]);
+  const auto muRow2Column1View = make_view<const T, 2>(augState["muRow2Column1"]);
+  const auto muRow2Column2View  = make_view<const T, 2>(augState["muRow2Column2"]);
+  const auto muIncView = make_view<const T, 2>(incFlds["mu"]);
+  const auto thetavIncView = make_view<const T, 2>(incFlds["virtual_potential_temperature"]);
+  auto qtIncView = make_view<T, 2>(incFlds["qt"]);
+  auto thetaIncView = make_view<T, 2>(incFlds["potential_temperature"]);
 
   for (atlas::idx_t jn = 0; jn < incFlds["mu"].shape(0); ++jn) {
     for (atlas::idx_t jl = 0; jl < incFlds["mu"].levels(); ++jl) {
@@ -577,17 +912,30 @@ void evalQtThetaTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augState)
   }
 }
 
+void evalQtThetaTL(atlas::FieldSet & incFlds, const atlas::FieldSet & augState) {
+  functions::dispatchPrecision(incFlds["qt"], [&](auto precision) {
+    return evalQtThetaTL<decltype(precision)>(incFlds, augState);
+  });
+}
+
 
+template <typename T>
 void evalQtThetaAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState) {
-  const auto muRecipDeterView = make_view<const double, 2>(augState["muRecipDeterminant"]);
-  const auto muRow1Column1View = make_view<const double, 2>(augState["muRow1Column1"]);
-  const auto muRow1Column2View = make_view<const double, 2>(augState["muRow1Column2"]);
-  const auto muRow2Column1View = make_view<const double, 2>(augState["muRow2Column1"]);
-  const auto muRow2Column2View  = make_view<const double, 2>(augState["muRow2Column2"]);
-  auto qtHatView = make_view<double, 2>(hatFlds["qt"]);
-  auto muHatView = make_view<double, 2>(hatFlds["mu"]);
-  auto thetavHatView = make_view<double, 2>(hatFlds["virtual_potential_temperature"]);
-  auto thetaHatView = make_view<double, 2>(hatFlds["potential_temperature"]);
+  vader::ScopedKernelTimer timer("mo::evalQtThetaAD");
+  timer.reads(augState, {"muRecipDeterminant", "muRow1Column1", "muRow1Column2", "muRow2Column1",
+                         "muRow2Column2"})
+       .reads(hatFlds, {"qt", "mu", "virtual_potential_temperature", "potential_temperature"})
+       .writes(hatFlds, {"qt", "mu", "virtual_potential_temperature", "potential_temperature"});
+
+  const auto muRecipDeterView = make_view<const T, 2>(augState["muRecipDeterminant"]);
+  const auto muRow1Column1View = make_view<const T, 2>(augState["muRow1Column1"]);
+  const auto muRow1Column2View = make_view<const T, 2>(augState["muRow1Column2"]);
+  const auto muRow2Column1View = make_view<const T, 2>(augState["muRow2Column1"]);
+  const auto muRow2Column2View  = make_view<const T, 2>(augState["muRow2Column2"]);
+  auto qtHatView = make_view<T, 2>(hatFlds["qt"]);
+  auto muHatView = make_view<T, 2>(hatFlds["mu"]);
+  auto thetavHatView = make_view<T, 2>(hatFlds["virtual_potential_temperature"]);
+  auto thetaHatView = make_view<T, 2>(hatFlds["potential_temperature"]);
 
   for (atlas::idx_t jn = 0; jn < hatFlds["mu"].shape(0); ++jn) {
     for (atlas::idx_t jl = 0; jl < hatFlds["mu"].levels(); ++jl) {
@@ -605,4 +953,10 @@ void evalQtThetaAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState)
   }
 }
 
+void evalQtThetaAD(atlas::FieldSet & hatFlds, const atlas::FieldSet & augState) {
+  functions::dispatchPrecision(hatFlds["qt"], [&](auto precision) {
+    return evalQtThetaAD<decltype(precision)>(hatFlds, augState);
+  });
+}
+
 }  // namespace mo
@@ -77,6 +77,8 @@ void qtTemperature2qqclqcfAD(atlas::FieldSet & hatFlds,
 /// \details This calculates the vertically-regressed geostrophic pressure increment field
 ///          in grid point space and adds it to the unbalanced pressure increment field to give
 ///          hydrostatic balance increments
+///          The interpolation weights and vertical regression matrices are double
+///          precision whatever the precision of the other fields.
 void evalHydrostaticPressureTL(atlas::FieldSet & incFlds,
                                const atlas::FieldSet & augStateFlds);
 
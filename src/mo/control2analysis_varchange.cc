@@ -13,6 +13,8 @@
 #include "mo/control2analysis_varchange.h"
 #include "mo/functions.h"
 
+#include "vader/StatsRegistry.h"
+
 using atlas::array::make_view;
 using atlas::util::Config;
 using atlas::idx_t;
@@ -20,11 +22,16 @@ using atlas::idx_t;
 namespace mo {
 
 
+template <typename T>
 void hexner2PThetav(atlas::FieldSet & fields) {
-  const auto rpView = make_view<const double, 2>(fields["height_levels"]);
-  const auto hexnerView = make_view<const double, 2>(fields["hydrostatic_exner_levels"]);
-  auto pView = make_view<double, 2>(fields["air_pressure_levels_minus_one"]);
-  auto vthetaView = make_view<double, 2>(fields["virtual_potential_temperature"]);
+  vader::ScopedKernelTimer timer("mo::hexner2PThetav");
+  timer.reads(fields, {"height_levels", "hydrostatic_exner_levels"})
+       .writes(fields, {"air_pressure_levels_minus_one", "virtual_potential_temperature"});
+
+  const auto rpView = make_view<const T, 2>(fields["height_levels"]);
+  const auto hexnerView = make_view<const T, 2>(fields["hydrostatic_exner_levels"]);
+  auto pView = make_view<T, 2>(fields["air_pressure_levels_minus_one"]);
+  auto vthetaView = make_view<T, 2>(fields["virtual_potential_temperature"]);
 
   for (idx_t jn = 0; jn < fields["hydrostatic_exner_levels"].shape(0); ++jn) {
     pView(jn, 0) = constants::p_zero * pow(hexnerView(jn, 0), (constants::cp / constants::rd));
@@ -37,10 +44,21 @@ void hexner2PThetav(atlas::FieldSet & fields) {
   }
 }
 
+void hexner2PThetav(atlas::FieldSet & fields) {
+  functions::dispatchPrecision(fields["air_pressure_levels_minus_one"], [&](auto precision) {
+    return hexner2PThetav<decltype(precision)>(fields);
+  });
+}
+
+template <typename T>
 void evalVirtualPotentialTemperature(atlas::FieldSet & fields) {
-  const auto qView = make_view<const double, 2>(fields["specific_humidity"]);
-  const auto thetaView = make_view<const double, 2>(fields["potential_temperature"]);
-  auto vthetaView = make_view<double, 2>(fields["virtual_potential_temperature"]);
+  vader::ScopedKernelTimer timer("mo::evalVirtualPotentialTemperature");
+  timer.reads(fields, {"specific_humidity", "potential_temperature"})
+       .writes(fields, {"virtual_potential_temperature"});
+
+  const auto qView = make_view<const T, 2>(fields["specific_humidity"]);
+  const auto thetaView = make_view<const T, 2>(fields["potential_temperature"]);
+  auto vthetaView = make_view<T, 2>(fields["virtual_potential_temperature"]);
 
   auto fspace = fields["virtual_potential_temperature"].functionspace();
 
@@ -53,13 +71,25 @@ void evalVirtualPotentialTemperature(atlas::FieldSet & fields) {
   functions::parallelFor(fspace, evaluateVTheta, conf);
 }
 
+void evalVirtualPotentialTemperature(atlas::FieldSet & fields) {
+  functions::dispatchPrecision(fields["virtual_potential_temperature"], [&](auto precision) {
+    return evalVirtualPotentialTemperature<decltype(precision)>(fields);
+  });
+}
+
 /// \details Calculate the hydrostatic exner pressure (on levels)
 ///          using air_pressure_minus_one and virtual potential temperature.
+template <typename T>
 void evalHydrostaticExnerLevels(atlas::FieldSet & fields) {
-  const auto rpView = make_view<const double, 2>(fields["height_levels"]);
-  const auto vthetaView = make_view<const double, 2>(fields["virtual_potential_temperature"]);
-  const auto pView = make_view<const double, 2>(fields["air_pressure_levels_minus_one"]);
-  auto hexnerView = make_view<double, 2>(fields["hydrostatic_exner_levels"]);
+  vader::ScopedKernelTimer timer("mo::evalHydrostaticExnerLevels");
+  timer.reads(fields, {"height_levels", "virtual_potential_temperature",
+                       "air_pressure_levels_minus_one"})
+       .writes(fields, {"hydrostatic_exner_levels"});
+
+  const auto rpView = make_view<const T, 2>(fields["height_levels"]);
+  const auto vthetaView = make_view<const T, 2>(fields["virtual_potential_temperature"]);
+  const auto pView = make_view<const T, 2>(fields["air_pressure_levels_minus_one"]);
+  auto hexnerView = make_view<T, 2>(fields["hydrostatic_exner_levels"]);
 
   for (idx_t jn = 0; jn < fields["hydrostatic_exner_levels"].shape(0); ++jn) {
     hexnerView(jn, 0) = pow(pView(jn, 0) / constants::p_zero,
@@ -72,12 +102,23 @@ void evalHydrostaticExnerLevels(atlas::FieldSet & fields) {
   }
 }
 
+void evalHydrostaticExnerLevels(atlas::FieldSet & fields) {
+  functions::dispatchPrecision(fields["hydrostatic_exner_levels"], [&](auto precision) {
+    return evalHydrostaticExnerLevels<decltype(precision)>(fields);
+  });
+}
+
 
 /// \details Calculate the hydrostatic pressure (on levels)
 ///           from hydrostatic exner
+template <typename T>
 void evalHydrostaticPressureLevels(atlas::FieldSet & fields) {
-  const auto hexnerView = make_view<double, 2>(fields["hydrostatic_exner_levels"]);
-  auto hpView = make_view<double, 2>(fields["hydrostatic_pressure_levels"]);
+  vader::ScopedKernelTimer timer("mo::evalHydrostaticPressureLevels");
+  timer.reads(fields, {"hydrostatic_exner_levels"})
+       .writes(fields, {"hydrostatic_pressure_levels"});
+
+  const auto hexnerView = make_view<T, 2>(fields["hydrostatic_exner_levels"]);
+  auto hpView = make_view<T, 2>(fields["hydrostatic_pressure_levels"]);
 
   for (idx_t jn = 0; jn < fields["hydrostatic_pressure_levels"].shape(0); ++jn) {
     for (idx_t jl = 0; jl < fields["hydrostatic_pressure_levels"].levels(); ++jl) {
@@ -87,15 +128,28 @@ void evalHydrostaticPressureLevels(atlas::FieldSet & fields) {
   }
 }
 
+void evalHydrostaticPressureLevels(atlas::FieldSet & fields) {
+  functions::dispatchPrecision(fields["hydrostatic_pressure_levels"], [&](auto precision) {
+    return evalHydrostaticPressureLevels<decltype(precision)>(fields);
+  });
+}
+
 
 /// \details Calculate qT increment from the sum of q, qcl and qcf increments
+template <typename T>
 void qqclqcf2qt(atlas::FieldSet & fields) {
-  const auto qIncView = make_view<const double, 2>(fields["specific_humidity"]);
-  const auto qclIncView = make_view<const double, 2>
+  vader::ScopedKernelTimer timer("mo::qqclqcf2qt");
+  timer.reads(fields, {"specific_humidity",
+                       "mass_content_of_cloud_liquid_water_in_atmosphere_layer",
+                       "mass_content_of_cloud_ice_in_atmosphere_layer"})
+       .writes(fields, {"qt"});
+
+  const auto qIncView = make_view<const T, 2>(fields["specific_humidity"]);
+  const auto qclIncView = make_view<const T, 2>
                     (fields["mass_content_of_cloud_liquid_water_in_atmosphere_layer"]);
-  const auto qcfIncView = make_view<const double, 2>
+  const auto qcfIncView = make_view<const T, 2>
                     (fields["mass_content_of_cloud_ice_in_atmosphere_layer"]);
-  auto qtIncView = make_view<double, 2>(fields["qt"]);
+  auto qtIncView = make_view<T, 2>(fields["qt"]);
 
   for (atlas::idx_t jn = 0; jn < fields["specific_humidity"].shape(0); ++jn) {
     for (atlas::idx_t jl = 0; jl < fields["specific_humidity"].levels(); ++jl) {
@@ -104,15 +158,27 @@ void qqclqcf2qt(atlas::FieldSet & fields) {
   }
 }
 
+void qqclqcf2qt(atlas::FieldSet & fields) {
+  functions::dispatchPrecision(fields["qt"], [&](auto precision) {
+    return qqclqcf2qt<decltype(precision)>(fields);
+  });
+}
+
 /// \details Calculate the dry air density
 ///          from the air_pressure_levels_minus_one,
 ///          air_temperature (which needs to be interpolated).
+template <typename T>
 void evalDryAirDensity(atlas::FieldSet & fields) {
-  const auto hlView = make_view<const double, 2>(fields["height_levels"]);
-  const auto hView = make_view<const double, 2>(fields["height"]);
-  const auto tView = make_view<const double, 2>(fields["air_temperature"]);
-  const auto pView = make_view<const double, 2>(fields["air_pressure_levels_minus_one"]);
-  auto rhoView = make_view<double, 2>(fields["dry_air_density_levels_minus_one"]);
+  vader::ScopedKernelTimer timer("mo::evalDryAirDensity");
+  timer.reads(fields, {"height_levels", "height", "air_temperature",
+                       "air_pressure_levels_minus_one"})
+       .writes(fields, {"dry_air_density_levels_minus_one"});
+
+  const auto hlView = make_view<const T, 2>(fields["height_levels"]);
+  const auto hView = make_view<const T, 2>(fields["height"]);
+  const auto tView = make_view<const T, 2>(fields["air_temperature"]);
+  const auto pView = make_view<const T, 2>(fields["air_pressure_levels_minus_one"]);
+  auto rhoView = make_view<T, 2>(fields["dry_air_density_levels_minus_one"]);
 
   for (idx_t jn = 0; jn < fields["dry_air_density_levels_minus_one"].shape(0); ++jn) {
     rhoView(jn, 0) = pView(jn, 0) / (constants::rd * tView(jn, 0));
@@ -125,19 +191,30 @@ void evalDryAirDensity(atlas::FieldSet & fields) {
   }
 }
 
+void evalDryAirDensity(atlas::FieldSet & fields) {
+  functions::dispatchPrecision(fields["dry_air_density_levels_minus_one"], [&](auto precision) {
+    return evalDryAirDensity<decltype(precision)>(fields);
+  });
+}
+
 /// \details Calculate exner pressure levels
 ///          from air_pressure_levels_minus_one and using hydrostatic balance relation
 ///          for topmost level
+template <typename T>
 void evalExnerPressureLevels(atlas::FieldSet & fields) {
   oops::Log::trace() << "[evalAirPressureLevels()] starting ..." << std::endl;
 
-  const auto exnerMinusOneView = make_view<const double, 2>(fields["exner_levels_minus_one"]);
+  vader::ScopedKernelTimer timer("mo::evalExnerPressureLevels");
+  timer.reads(fields, {"exner_levels_minus_one", "virtual_potential_temperature", "height_levels"})
+       .writes(fields, {"exner_pressure_levels"});
+
+  const auto exnerMinusOneView = make_view<const T, 2>(fields["exner_levels_minus_one"]);
   // Note that it is unclear whether this should be virtual_potential_temperature
   // or potential_temperature in this case. Either way the difference will be tiny since
   // the amount of moisture at a model top is tiny.
-  const auto vthetaView = make_view<const double, 2>(fields["virtual_potential_temperature"]);
-  const auto hlView = make_view<const double, 2>(fields["height_levels"]);
-  auto exnerView = make_view<double, 2>(fields["exner_pressure_levels"]);
+  const auto vthetaView = make_view<const T, 2>(fields["virtual_potential_temperature"]);
+  const auto hlView = make_view<const T, 2>(fields["height_levels"]);
+  auto exnerView = make_view<T, 2>(fields["exner_pressure_levels"]);
 
   idx_t levels(fields["exner_pressure_levels"].levels());
   for (idx_t jn = 0; jn < fields["exner_pressure_levels"].shape(0); ++jn) {
@@ -154,16 +231,29 @@ void evalExnerPressureLevels(atlas::FieldSet & fields) {
   }
 }
 
+void evalExnerPressureLevels(atlas::FieldSet & fields) {
+  functions::dispatchPrecision(fields["exner_pressure_levels"], [&](auto precision) {
+    return evalExnerPressureLevels<decltype(precision)>(fields);
+  });
+}
+
 
+template <typename T>
 void evalMoistureControlDependencies(atlas::FieldSet & fields) {
-  const auto qtView = make_view<const double, 2>(fields["qt"]);
-  const auto qView = make_view<const double, 2>(fields["specific_humidity"]);
-  const auto thetaView = make_view<const double, 2>(fields["potential_temperature"]);
-  const auto exnerView = make_view<const double, 2>(fields["exner"]);
-  const auto dlsvpdTView = make_view<const double, 2>(fields["dlsvpdT"]);
-  const auto qsatView = make_view<const double, 2>(fields["qsat"]);
-  const auto muAView = make_view<const double, 2>(fields["muA"]);
-  const auto muH1View = make_view<const double, 2>(fields["muH1"]);
+  vader::ScopedKernelTimer timer("mo::evalMoistureControlDependencies");
+  timer.reads(fields, {"qt", "specific_humidity", "potential_temperature", "exner", "dlsvpdT",
+                       "qsat", "muA", "muH1"})
+       .writes(fields, {"muRow1Column1", "muRow1Column2", "muRow2Column1", "muRow2Column2",
+                        "muRecipDeterminant"});
+
+  const auto qtView = make_view<const T, 2>(fields["qt"]);
+  const auto qView = make_view<const T, 2>(fields["specific_humidity"]);
+  const auto thetaView = make_view<const T, 2>(fields["potential_temperature"]);
+  const auto exnerView = make_view<const T, 2>(fields["exner"]);
+  const auto dlsvpdTView = make_view<const T, 2>(fields["dlsvpdT"]);
+  const auto qsatView = make_view<const T, 2>(fields["qsat"]);
+  const auto muAView = make_view<const T, 2>(fields["muA"]);
+  const auto muH1View = make_view<const T, 2>(fields["muH1"]);
 
   // this is effectively the (2x2) matrix = A
   //  (mu')       = A (qt')     where A is
@@ -172,11 +262,11 @@ void evalMoistureControlDependencies(atlas::FieldSet & fields) {
   //  ( muA/qsat    - (muA/qsat) muH1 qT exner_bar dlsvpdT )
   //  (                                                 )
   //  (c_v theta q     (1+ cv) q                        )
-  auto muRow1Column1View = make_view<double, 2>(fields["muRow1Column1"]);
-  auto muRow1Column2View = make_view<double, 2>(fields["muRow1Column2"]);
-  auto muRow2Column1View = make_view<double, 2>(fields["muRow2Column1"]);
-  auto muRow2Column2View = make_view<double, 2>(fields["muRow2Column2"]);
-  auto muRecipDeterminantView = make_view<double, 2>(fields["muRecipDeterminant"]);
+  auto muRow1Column1View = make_view<T, 2>(fields["muRow1Column1"]);
+  auto muRow1Column2View = make_view<T, 2>(fields["muRow1Column2"]);
+  auto muRow2Column1View = make_view<T, 2>(fields["muRow2Column1"]);
+  auto muRow2Column2View = make_view<T, 2>(fields["muRow2Column2"]);
+  auto muRecipDeterminantView = make_view<T, 2>(fields["muRecipDeterminant"]);
 
   // the comments below are there to allow checking with the VAR code.
   for (atlas::idx_t jn = 0; jn < fields["potential_temperature"].shape(0); ++jn) {
@@ -195,4 +285,10 @@ void evalMoistureControlDependencies(atlas::FieldSet & fields) {
   }
 }
 
+void evalMoistureControlDependencies(atlas::FieldSet & fields) {
+  functions::dispatchPrecision(fields["muRow1Column1"], [&](auto precision) {
+    return evalMoistureControlDependencies<decltype(precision)>(fields);
+  });
+}
+
 }  // namespace mo
@@ -5,111 +5,191 @@
  * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
  */
 
-#include <Eigen/Core>
+#include <netcdf.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 #include "atlas/array.h"
 #include "atlas/field.h"
 
+#include "eckit/mpi/Comm.h"
+
 #include "mo/constants.h"
 #include "mo/functions.h"
+#include "mo/lookup_tables.h"
 
 #include "oops/base/Variables.h"
 #include "oops/util/Logger.h"
 
+#include "vader/StatsRegistry.h"
+
 using atlas::array::make_view;
 
 namespace mo {
 namespace functions {
 
+std::vector<const double *> readLookUps(const std::string & filePath,
+                                        const oops::Variables & vars,
+                                        const std::size_t lookupSize,
+                                        std::vector<double> & buffer) {
+  int ncid = -1;
+  // closes the file (if open) and throws
+  auto fail = [&](const std::string & message) {
+    if (ncid >= 0) nc_close(ncid);
+    oops::Log::error() << "ERROR - " << message << std::endl;
+    throw std::runtime_error("reading lookup tables from " + filePath + " failed");
+  };
+  auto check = [&](const int status, const std::string & call, const std::string & name) {
+    if (status != NC_NOERR) {
+      fail(call + " " + name + " failed for " + filePath + ": " + nc_strerror(status));
+    }
+  };
+
+  check(nc_open(filePath.c_str(), NC_NOWRITE, &ncid), "nc_open", filePath);
+  buffer.resize(vars.size() * lookupSize);
+  std::vector<const double *> lookUps(vars.size());
+  for (std::size_t i = 0; i < vars.size(); ++i) {
+    int varid, ndims;
+    int dimids[NC_MAX_VAR_DIMS];
+    check(nc_inq_varid(ncid, vars[i].c_str(), &varid), "nc_inq_varid", vars[i]);
+    check(nc_inq_varndims(ncid, varid, &ndims), "nc_inq_varndims", vars[i]);
+    check(nc_inq_vardimid(ncid, varid, dimids), "nc_inq_vardimid", vars[i]);
+    std::size_t size = 1;
+    for (int j = 0; j < ndims; ++j) {
+      std::size_t length;
+      check(nc_inq_dimlen(ncid, dimids[j], &length), "nc_inq_dimlen", vars[i]);
+      size *= length;
+    }
+    if (size != lookupSize) {
+      fail(vars[i] + " in " + filePath + " has " + std::to_string(size) + " values, "
+           + std::to_string(lookupSize) + " expected");
+    }
+    double * values = buffer.data() + i * lookupSize;
+    check(nc_get_var_double(ncid, varid, values), "nc_get_var_double", vars[i]);
+    lookUps[i] = values;
+  }
+  const int status = nc_close(ncid);
+  ncid = -1;
+  check(status, "nc_close", filePath);
+
+  return lookUps;
+}
+
 std::vector<double> getLookUp(const std::string & sVPFilePath,
                               const std::string & shortName,
                               const std::size_t lookupSize) {
-  std::vector<double> values(lookupSize, 0);
-
-  umGetLookUp_f90(static_cast<int>(sVPFilePath.size()),
-                  sVPFilePath.c_str(),
-                  static_cast<int>(shortName.size()),
-                  shortName.c_str(),
-                  static_cast<int>(lookupSize),
-                  values[0]);
-
-  return std::vector<double>(values.begin(), values.end());
+  std::vector<double> values;
+  readLookUps(sVPFilePath, oops::Variables(std::vector<std::string>{shortName}),
+              lookupSize, values);
+  return values;
 }
 
 
 std::vector<std::vector<double>> getLookUps(const std::string & sVPFilePath,
                                             const oops::Variables & vars,
                                             const std::size_t lookupSize) {
-  std::vector<std::vector<double>> values(vars.size(), std::vector<double>(lookupSize));
-
-  for (std::size_t i = 0; i < values.size(); ++i) {
-    values[i] = getLookUp(sVPFilePath, vars[i], lookupSize);
+  std::vector<double> buffer;
+  const std::vector<const double *> lookUps = readLookUps(sVPFilePath, vars, lookupSize,
+                                                          buffer);
+  std::vector<std::vector<double>> values;
+  values.reserve(vars.size());
+  for (const double * lookUp : lookUps) {
+    values.emplace_back(lookUp, lookUp + lookupSize);
   }
 
   return values;
 }
 
+template <typename T>
 void getMIOFields(atlas::FieldSet & augStateFlds) {
-  const auto rhtView = make_view<const double, 2>(augStateFlds["rht"]);
-  const auto clView = make_view<const double, 2>
+  vader::ScopedKernelTimer timer("mo::getMIOFields");
+  timer.reads(augStateFlds, {"rht", "liquid_cloud_volume_fraction_in_atmosphere_layer",
+                             "ice_cloud_volume_fraction_in_atmosphere_layer"})
+       .writes(augStateFlds, {"cleff", "cfeff"});
+
+  const auto rhtView = make_view<const T, 2>(augStateFlds["rht"]);
+  const auto clView = make_view<const T, 2>
                 (augStateFlds["liquid_cloud_volume_fraction_in_atmosphere_layer"]);
-  const auto cfView = make_view<const double, 2>
+  const auto cfView = make_view<const T, 2>
                 (augStateFlds["ice_cloud_volume_fraction_in_atmosphere_layer"]);
 
-  auto cleffView = make_view<double, 2>(augStateFlds["cleff"]);
-  auto cfeffView = make_view<double, 2>(augStateFlds["cfeff"]);
-
-  Eigen::MatrixXd mioCoeffCl = createMIOCoeff(constants::mioCoefficientsFilePath, "qcl_coef");
-  Eigen::MatrixXd mioCoeffCf = createMIOCoeff(constants::mioCoefficientsFilePath, "qcf_coef");
-
-  for  (atlas::idx_t jn = 0; jn < augStateFlds["rht"].shape(0); ++jn) {
-    for (int jl = 0; jl < augStateFlds["rht"].levels(); ++jl) {
-      if (jl < constants::mioLevs) {
-        std::size_t ibin = (rhtView(jn, jl) > 1.0) ? constants::mioBins - 1 :
-                           static_cast<std::size_t>(floor(rhtView(jn, jl) / constants::rHTBin));
-
-        std::double_t ceffdenom = (1.0 -  clView(jn, jl) * cfView(jn, jl) );
-        if (ceffdenom > constants::tol) {
-          std::double_t clcf = clView(jn, jl) * cfView(jn, jl);
-          cleffView(jn, jl) = mioCoeffCl(jl, ibin) * (clView(jn, jl) - clcf) / ceffdenom;
-          cfeffView(jn, jl) = mioCoeffCf(jl, ibin) * (cfView(jn, jl) - clcf) / ceffdenom;
-        } else {
-          cleffView(jn, jl) = 0.5;
-          cfeffView(jn, jl) = 0.5;
-        }
-      } else {
-        cleffView(jn, jl) = 0.0;
-        cfeffView(jn, jl) = 0.0;
-      }
+  auto cleffView = make_view<T, 2>(augStateFlds["cleff"]);
+  auto cfeffView = make_view<T, 2>(augStateFlds["cfeff"]);
+
+  const MIOCoefficients & mioCoeff = getMIOCoefficients();
+
+  const atlas::idx_t nnodes = augStateFlds["rht"].shape(0);
+  const atlas::idx_t levels = augStateFlds["rht"].levels();
+  // The coefficients only cover the levels below mioLevs; above, cleff and cfeff are 0
+  const atlas::idx_t mioLevels = std::min(levels, static_cast<atlas::idx_t>(constants::mioLevs));
+  const std::double_t rHTBinInverse = 1.0 / constants::rHTBin;
+
+#pragma omp parallel for schedule(static)
+  for (atlas::idx_t jn = 0; jn < nnodes; ++jn) {
+#pragma omp simd
+    for (atlas::idx_t jl = 0; jl < mioLevels; ++jl) {
+      const std::double_t rht = rhtView(jn, jl);
+      const std::size_t ibin = (rht > 1.0) ? constants::mioBins - 1 :
+                               static_cast<std::size_t>(std::max(rht, 0.0) * rHTBinInverse);
+      const MIOCoefficient & coeff = mioCoeff[jl][ibin];
+
+      const std::double_t clcf = clView(jn, jl) * cfView(jn, jl);
+      const std::double_t ceffdenom = 1.0 - clcf;
+      // Selected rather than branched on: cleff and cfeff are 0.5 where the
+      // denominator is too small
+      const bool valid = ceffdenom > constants::tol;
+      const std::double_t denom = valid ? ceffdenom : 1.0;
+      const std::double_t cleff = coeff.cl * (clView(jn, jl) - clcf) / denom;
+      const std::double_t cfeff = coeff.cf * (cfView(jn, jl) - clcf) / denom;
+      cleffView(jn, jl) = valid ? cleff : 0.5;
+      cfeffView(jn, jl) = valid ? cfeff : 0.5;
+    }
+    for (atlas::idx_t jl = mioLevels; jl < levels; ++jl) {
+      cleffView(jn, jl) = 0.0;
+      cfeffView(jn, jl) = 0.0;
     }
   }
 }
 
-Eigen::MatrixXd createMIOCoeff(const std::string mioFileName,
-                               const std::string s)
-{
-    Eigen::MatrixXd mioCoeff(static_cast<std::size_t>(constants::mioLevs),
-                             static_cast<std::size_t>(constants::mioBins));
-
-    std::vector<double> valuesvec(constants::mioLookUpLength, 0);
-
-    umGetLookUp2D_f90(static_cast<int>(mioFileName.size()),
-                      mioFileName.c_str(),
-                      static_cast<int>(s.size()),
-                      s.c_str(),
-                      static_cast<int>(constants::mioBins),
-                      static_cast<int>(constants::mioLevs),
-                      valuesvec[0]);
-
-    for (int j = 0; j < constants::mioLevs; ++j) {
-        for (int i = 0; i < constants::mioBins; ++i) {
-            // Fortran returns column major order, but C++ needs row major
-            mioCoeff(j, i) = valuesvec[i * constants::mioLevs+j];
-        }
+void getMIOFields(atlas::FieldSet & augStateFlds) {
+  dispatchPrecision(augStateFlds["cleff"], [&](auto precision) {
+    return getMIOFields<decltype(precision)>(augStateFlds);
+  });
+}
+
+namespace {
+/// \brief variables of the MIO coefficients in constants::mioCoefficientsFilePath
+oops::Variables mioLookUpVars() {
+  return oops::Variables(std::vector<std::string>{"qcl_coef", "qcf_coef"});
+}
+}  // namespace
+
+void loadMIOCoefficients(const eckit::mpi::Comm & comm) {
+  LookUpTableRegistry::global().get(constants::mioCoefficientsFilePath, mioLookUpVars(),
+                                    constants::mioLookUpLength, comm);
+}
+
+const MIOCoefficients & getMIOCoefficients() {
+  // Initialised once, on the first call (thread-safe), from the tables loaded by
+  // loadMIOCoefficients or else read by this task
+  static const MIOCoefficients mioCoeff = []() {
+    const std::vector<LookUpTable> tables = LookUpTableRegistry::global().get(
+      constants::mioCoefficientsFilePath, mioLookUpVars(), constants::mioLookUpLength);
+    MIOCoefficients coefficients;
+    for (std::size_t j = 0; j < constants::mioLevs; ++j) {
+      for (std::size_t i = 0; i < constants::mioBins; ++i) {
+        // The file holds the coefficients bin by bin (levels varying fastest)
+        coefficients[j][i].cl = tables[0][i * constants::mioLevs + j];
+        coefficients[j][i].cf = tables[1][i * constants::mioLevs + j];
+      }
     }
-    return mioCoeff;
+    return coefficients;
+  }();
+  return mioCoeff;
 }
 
 }  // namespace functions
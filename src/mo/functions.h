@@ -7,16 +7,22 @@
 
 #pragma once
 
-#include <Eigen/Core>
+#include <array>
 #include <string>
 #include <vector>
 
 #include "atlas/field.h"
 #include "atlas/functionspace.h"
 
+#include "eckit/mpi/Comm.h"
+
+#include "mo/constants.h"
+
 #include "oops/base/Variables.h"
 #include "oops/util/Logger.h"
 
+#include "vader/ColumnSelection.h"
+
 namespace mo {
 namespace functions {
 //--
@@ -37,6 +43,22 @@ void executeFunc(const atlas::FunctionSpace & fspace, const Functor & functor) {
   }
 }
 
+/// \brief procedure to call a functor with a value of the floating-point type
+///        (float or double) held by the given field; the functor is typically
+///        a generic lambda instantiating a kernel templated on the precision
+template<typename Functor>
+auto dispatchPrecision(const atlas::Field & field, const Functor & functor) {
+  if (field.datatype().kind() == atlas::array::DataType::kind<float>()) {
+    return functor(float());
+  } else if (field.datatype().kind() != atlas::array::DataType::kind<double>()) {
+    oops::Log::error() << "ERROR - field " << field.name() << " has datatype "
+                       << field.datatype().str() << " (only real32 and real64 allowed)"
+                       << std::endl;
+    throw std::runtime_error("a precision dispatch failed");
+  }
+  return functor(double());
+}
+
 /// \brief wrapper for 'parallel_for'
 template<typename Functor>
 void parallelFor(const atlas::FunctionSpace & fspace,
@@ -45,10 +67,48 @@ void parallelFor(const atlas::FunctionSpace & fspace,
   executeFunc(fspace, [&](const auto& fspace){fspace.parallel_for(conf, functor);});
 }
 
+/// \brief wrapper for 'parallel_for' restricted to the selected columns;
+///        the functor takes the column and level indices, and the number of
+///        levels must be given in the configuration
+template<typename Functor>
+void parallelFor(const atlas::FunctionSpace & fspace,
+                 const vader::ColumnSelection & columns,
+                 const Functor& functor,
+                 const atlas::util::Config& conf = atlas::util::Config()) {
+  if (columns.all()) {
+    parallelFor(fspace, functor, conf);
+    return;
+  }
+  atlas::idx_t levels(1);
+  conf.get("levels", levels);
+  const atlas::idx_t nselected = columns.size(fspace.size());
+  const atlas::idx_t * selected = columns.columns().data();
+#pragma omp parallel for schedule(static)
+  for (atlas::idx_t k = 0; k < nselected; ++k) {
+    for (atlas::idx_t jl = 0; jl < levels; ++jl) {
+      functor(selected[k], jl);
+    }
+  }
+}
+
 
 //--
 // ++ I/O processing ++
 
+/// \brief function to read arrays from a netcdf file, opening the file only once
+/// filePath: the path and name of the netcdf file
+/// vars: list of arrays, with the same number of values, to be read from the file
+/// lookupSize: number of values of each array
+/// buffer: resized to hold all the arrays, one after the other; the values of
+///         multidimensional arrays are in the order of the file (last dimension
+///         varying fastest)
+/// returns pointers to the first value of each array in buffer
+///
+std::vector<const double *> readLookUps(const std::string & filePath,
+                                        const oops::Variables & vars,
+                                        const std::size_t lookupSize,
+                                        std::vector<double> & buffer);
+
 /// \brief function to read data from a netcdf file
 /// sVPFilePath: the path and name of the netcdf file
 /// shortname: array to be read from the file
@@ -71,30 +131,30 @@ std::vector<std::vector<double>> getLookUps(const std::string & sVPFilePath,
 ///          for the moisture incrementing operator (MIO)
 void getMIOFields(atlas::FieldSet & augStateFlds);
 
-/// \details This extracts the scaling coefficients that are applied to Cleff and Cfeff
-///          to generate the qcl and qcf increments in the moisture incrementing operator (MIO)
-///          The string s can be "qcl_coef" or "qcf_coef"
-Eigen::MatrixXd createMIOCoeff(const std::string mioFileName,
-                               const std::string s);
-
-extern "C" {
-  void umGetLookUp_f90(
-    const int &,
-    const char *,
-    const int &,
-    const char *,
-    const int &,
-    double &);
-
-  void umGetLookUp2D_f90(
-    const int &,
-    const char *,
-    const int &,
-    const char *,
-    const int &,
-    const int &,
-    double &);
-}  // extern "C"
+/// \brief scaling coefficients of the moisture incrementing operator (MIO) for one
+///        level and one rht bin, applied to Cleff (cl) and Cfeff (cf)
+struct MIOCoefficient {
+  double cl;
+  double cf;
+};
+
+/// \brief MIO coefficients indexed by level then rht bin: the coefficients of all the
+///        bins of a level are contiguous, and those for qcl and qcf are side by side
+typedef std::array<std::array<MIOCoefficient, constants::mioBins>, constants::mioLevs>
+  MIOCoefficients;
+
+/// \details getMIOCoefficients returns the scaling coefficients that are applied to
+///          Cleff and Cfeff to generate the qcl and qcf increments in the moisture
+///          incrementing operator (MIO), read from constants::mioCoefficientsFilePath on
+///          the first call only, by each task that has not loaded them with
+///          loadMIOCoefficients.
+const MIOCoefficients & getMIOCoefficients();
+
+/// \details loadMIOCoefficients loads the MIO coefficients on the first task of comm
+///          and broadcasts them to the other tasks. Collective over comm: it must be
+///          called by all its tasks, outside parallel regions, before the first call of
+///          getMIOCoefficients (or getMIOFields) to take effect.
+void loadMIOCoefficients(const eckit::mpi::Comm & comm = eckit::mpi::comm());
 
 }  // namespace functions
 }  // namespace mo
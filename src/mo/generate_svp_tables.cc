@@ -0,0 +1,108 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+/// \file generate_svp_tables.cc
+/// \brief build-time generator of the saturation vapour pressure lookup tables
+///
+/// Writes a header holding the tables svp, dlsvp, svpW and dlsvpW as constexpr
+/// arrays, for the temperatures TLoBound, TLoBound + Tinc, ..., THiBound of
+/// mo/constants.h. The vapour pressures (Pa) are given by the Goff-Gratch
+/// formulae, over ice below zerodegc and over water above it for svp, and over water
+/// at all temperatures for svpW. dlsvp and dlsvpW are the derivatives of the
+/// logarithm of the vapour pressures with respect to temperature (1/K).
+///
+/// Usage: vader_generate_svp_tables <output header>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mo/constants.h"
+
+namespace {
+
+const double ln10 = std::log(10.0);
+
+// Goff-Gratch over water: steam point (K) and vapour pressure there (hPa)
+const double tSteam = 373.16;
+const double esSteam = 1013.246;
+// Goff-Gratch over ice: ice point (K) and vapour pressure there (hPa)
+const double tIce = 273.16;
+const double esIce = 6.1071;
+
+/// \brief log10 of the vapour pressure over water (hPa) and its derivative
+void waterLog10(const double t, double & log10es, double & dlog10esdT) {
+  const double a = std::pow(10.0, 11.344 * (1.0 - t / tSteam));
+  const double b = std::pow(10.0, -3.49149 * (tSteam / t - 1.0));
+  log10es = -7.90298 * (tSteam / t - 1.0) + 5.02808 * std::log10(tSteam / t)
+            - 1.3816e-7 * (a - 1.0) + 8.1328e-3 * (b - 1.0) + std::log10(esSteam);
+  dlog10esdT = 7.90298 * tSteam / (t * t) - 5.02808 / (t * ln10)
+               + 1.3816e-7 * ln10 * 11.344 / tSteam * a
+               + 8.1328e-3 * ln10 * 3.49149 * tSteam / (t * t) * b;
+}
+
+/// \brief log10 of the vapour pressure over ice (hPa) and its derivative
+void iceLog10(const double t, double & log10es, double & dlog10esdT) {
+  log10es = -9.09718 * (tIce / t - 1.0) - 3.56654 * std::log10(tIce / t)
+            + 0.876793 * (1.0 - t / tIce) + std::log10(esIce);
+  dlog10esdT = 9.09718 * tIce / (t * t) + 3.56654 / (t * ln10) - 0.876793 / tIce;
+}
+
+void writeTable(std::ostream & os, const std::string & name, const std::string & comment,
+                const std::vector<double> & values) {
+  os << "// " << comment << "\n";
+  os << "constexpr double " << name << "[" << values.size() << "] = {\n";
+  char value[32];
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    std::snprintf(value, sizeof(value), "%.17g", values[i]);
+    os << (i % 4 == 0 ? "  " : " ") << value << (i + 1 < values.size() ? "," : "")
+       << (i % 4 == 3 || i + 1 == values.size() ? "\n" : "");
+  }
+  os << "};\n\n";
+}
+
+}  // namespace
+
+int main(int argc, char * argv[]) {
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " <output header>" << std::endl;
+    return 1;
+  }
+
+  const std::size_t n = mo::constants::svpLookUpLength;
+  std::vector<double> svp(n), dlsvp(n), svpW(n), dlsvpW(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    const double t = mo::constants::TLoBound + static_cast<double>(i) * mo::constants::Tinc;
+    double log10es, dlog10esdT;
+    waterLog10(t, log10es, dlog10esdT);
+    // hPa -> Pa
+    svpW[i] = 100.0 * std::pow(10.0, log10es);
+    dlsvpW[i] = ln10 * dlog10esdT;
+    if (t < mo::constants::zerodegc) iceLog10(t, log10es, dlog10esdT);
+    svp[i] = 100.0 * std::pow(10.0, log10es);
+    dlsvp[i] = ln10 * dlog10esdT;
+  }
+
+  std::ofstream os(argv[1]);
+  os << "// Generated by vader_generate_svp_tables from mo/generate_svp_tables.cc: do not edit.\n"
+     << "\n"
+     << "#pragma once\n"
+     << "\n"
+     << "namespace mo {\n"
+     << "namespace svptables {\n"
+     << "\n";
+  writeTable(os, "svp", "saturation vapour pressure over ice below 0 C, water above (Pa)", svp);
+  writeTable(os, "dlsvp", "derivative of the logarithm of svp (1/K)", dlsvp);
+  writeTable(os, "svpW", "saturation vapour pressure over water (Pa)", svpW);
+  writeTable(os, "dlsvpW", "derivative of the logarithm of svpW (1/K)", dlsvpW);
+  os << "}  // namespace svptables\n"
+     << "}  // namespace mo\n";
+  return os ? 0 : 1;
+}
@@ -0,0 +1,296 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifdef VADER_MO_SHARED_TABLES
+#include <mpi.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "eckit/mpi/Comm.h"
+
+#include "mo/functions.h"
+#include "mo/lookup_tables.h"
+
+#include "oops/base/Variables.h"
+#include "oops/util/Logger.h"
+
+namespace mo {
+
+namespace {
+
+/// \brief rank reading the files
+const std::size_t root = 0;
+
+/// \brief reads the tables on the root rank of comm into buffer (of the size of all
+///        the tables) and broadcasts them to the other ranks; all the ranks throw if
+///        the root failed to read them
+void readAndBroadcast(const std::string & filePath, const oops::Variables & vars,
+                      const std::size_t lookupSize, std::vector<double> & buffer,
+                      const eckit::mpi::Comm & comm, std::mutex & readMutex) {
+  int failed = 0;
+  if (comm.rank() == root) {
+    try {
+      std::lock_guard<std::mutex> readLock(readMutex);
+      functions::readLookUps(filePath, vars, lookupSize, buffer);
+    } catch (const std::exception &) {
+      failed = 1;
+    }
+  }
+  comm.broadcast(failed, root);
+  if (failed) throw std::runtime_error("reading lookup tables from " + filePath + " failed");
+  comm.broadcast(buffer.begin(), buffer.end(), root);
+}
+
+#ifdef VADER_MO_SHARED_TABLES
+/// \brief reads the tables into a shared-memory window of the ranks of comm on each
+///        node, filled by the first rank of the node: the root reads the file, and
+///        broadcasts the tables to the first ranks of the other nodes. The window is
+///        returned in window, also when reading fails, and must be freed collectively.
+const double * readIntoSharedWindow(const std::string & filePath,
+                                    const oops::Variables & vars,
+                                    const std::size_t lookupSize,
+                                    const eckit::mpi::Comm & comm,
+                                    std::mutex & readMutex,
+                                    MPI_Win & window) {
+  const int count = static_cast<int>(vars.size() * lookupSize);
+  const MPI_Comm mpiComm = MPI_Comm_f2c(comm.communicator());
+  int rank, nodeRank;
+  MPI_Comm_rank(mpiComm, &rank);
+  MPI_Comm nodeComm;
+  MPI_Comm_split_type(mpiComm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodeComm);
+  MPI_Comm_rank(nodeComm, &nodeRank);
+  // The root is the first rank of its node, since ranks keep their order
+  MPI_Comm leadersComm;
+  MPI_Comm_split(mpiComm, nodeRank == 0 ? 0 : MPI_UNDEFINED, rank, &leadersComm);
+
+  double * tables;
+  const MPI_Aint bytes = nodeRank == 0 ? static_cast<MPI_Aint>(count * sizeof(double)) : 0;
+  MPI_Win_allocate_shared(bytes, sizeof(double),
+                          MPI_INFO_NULL, nodeComm, &tables, &window);
+  if (nodeRank != 0) {
+    MPI_Aint size;
+    int displacement;
+    MPI_Win_shared_query(window, 0, &size, &displacement, &tables);
+  }
+  MPI_Win_fence(0, window);
+
+  int failed = 0;
+  if (nodeRank == 0) {
+    if (static_cast<std::size_t>(rank) == root) {
+      try {
+        std::vector<double> buffer;
+        std::lock_guard<std::mutex> readLock(readMutex);
+        functions::readLookUps(filePath, vars, lookupSize, buffer);
+        std::copy(buffer.begin(), buffer.end(), tables);
+      } catch (const std::exception &) {
+        failed = 1;
+      }
+    }
+    MPI_Bcast(&failed, 1, MPI_INT, 0, leadersComm);
+    if (!failed) MPI_Bcast(tables, count, MPI_DOUBLE, 0, leadersComm);
+    MPI_Comm_free(&leadersComm);
+  }
+  MPI_Bcast(&failed, 1, MPI_INT, 0, nodeComm);
+  MPI_Win_fence(0, window);
+  MPI_Comm_free(&nodeComm);
+
+  if (failed) throw std::runtime_error("reading lookup tables from " + filePath + " failed");
+  return tables;
+}
+#endif
+
+}  // namespace
+
+LookUpTableRegistry & LookUpTableRegistry::global() {
+  static LookUpTableRegistry registry;
+  return registry;
+}
+
+LookUpTable LookUpTableRegistry::get(const std::string & filePath,
+                                     const std::string & shortName,
+                                     const std::size_t lookupSize) {
+  return get(filePath, oops::Variables(std::vector<std::string>{shortName}), lookupSize)
+           .front();
+}
+
+std::vector<LookUpTable> LookUpTableRegistry::get(const std::string & filePath,
+                                                  const oops::Variables & vars,
+                                                  const std::size_t lookupSize) {
+  // The read lock is held until the tables are cached: other threads asking for the
+  // same tables must wait for them anyway.
+  std::lock_guard<std::mutex> readLock(readMutex_);
+  std::vector<std::string> missing;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < vars.size(); ++i) {
+      if (!find(filePath, vars[i], lookupSize)) missing.push_back(vars[i]);
+    }
+  }
+
+  if (!missing.empty()) {
+    oops::Log::trace() << "[LookUpTableRegistry] reading " << missing.size()
+                       << " table(s) from " << filePath << std::endl;
+    auto buffer = std::make_shared<std::vector<double>>();
+    const double * data =
+      functions::readLookUps(filePath, oops::Variables(missing), lookupSize, *buffer).front();
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The tables are one after the other in the buffer
+    for (std::size_t i = 0; i < missing.size(); ++i) {
+      tables_[std::make_pair(filePath, missing[i])] =
+        LookUpTable(buffer, data + i * lookupSize, lookupSize);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<LookUpTable> tables;
+  tables.reserve(vars.size());
+  for (std::size_t i = 0; i < vars.size(); ++i) {
+    tables.push_back(find(filePath, vars[i], lookupSize));
+  }
+  return tables;
+}
+
+std::vector<LookUpTable> LookUpTableRegistry::get(const std::string & filePath,
+                                                  const oops::Variables & vars,
+                                                  const std::size_t lookupSize,
+                                                  const eckit::mpi::Comm & comm) {
+#ifdef _OPENMP
+  if (omp_in_parallel()) {
+    oops::Log::error() << "ERROR - lookup tables from " << filePath
+                       << " loaded collectively inside a parallel region" << std::endl;
+    throw std::runtime_error("collective lookup table load inside a parallel region");
+  }
+#endif
+  // Only collective calls change the tables of comm, so every rank finds the same
+  // tables missing.
+  std::vector<std::string> missing;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Tables & loaded = collectiveTables_[comm.communicator()];
+    for (std::size_t i = 0; i < vars.size(); ++i) {
+      const auto found = loaded.find(std::make_pair(filePath, vars[i]));
+      if (found == loaded.end()) {
+        missing.push_back(vars[i]);
+      } else if (found->second.size() != lookupSize) {
+        oops::Log::error() << "ERROR - lookup table " << vars[i] << " from " << filePath
+                           << " has " << found->second.size() << " values, " << lookupSize
+                           << " requested" << std::endl;
+        throw std::runtime_error("lookup table size mismatch");
+      }
+    }
+  }
+
+  if (!missing.empty()) {
+    oops::Log::trace() << "[LookUpTableRegistry] loading " << missing.size()
+                       << " table(s) from " << filePath << std::endl;
+    const oops::Variables missingVars(missing);
+    std::shared_ptr<const void> owner;
+    const double * data;
+    if (comm.size() == 1) {
+      auto buffer = std::make_shared<std::vector<double>>();
+      std::lock_guard<std::mutex> readLock(readMutex_);
+      data = functions::readLookUps(filePath, missingVars, lookupSize, *buffer).front();
+      owner = buffer;
+    } else {
+#ifdef VADER_MO_SHARED_TABLES
+      MPI_Win window;
+      try {
+        data = readIntoSharedWindow(filePath, missingVars, lookupSize, comm, readMutex_,
+                                    window);
+      } catch (const std::exception &) {
+        MPI_Win_free(&window);
+        throw;
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      windows_[comm.communicator()].push_back(MPI_Win_c2f(window));
+#else
+      auto buffer = std::make_shared<std::vector<double>>(missing.size() * lookupSize);
+      readAndBroadcast(filePath, missingVars, lookupSize, *buffer, comm, readMutex_);
+      data = buffer->data();
+      owner = buffer;
+#endif
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Tables & loaded = collectiveTables_[comm.communicator()];
+    for (std::size_t i = 0; i < missing.size(); ++i) {
+      loaded[std::make_pair(filePath, missing[i])] =
+        LookUpTable(owner, data + i * lookupSize, lookupSize);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const Tables & loaded = collectiveTables_[comm.communicator()];
+  std::vector<LookUpTable> tables;
+  tables.reserve(vars.size());
+  for (std::size_t i = 0; i < vars.size(); ++i) {
+    tables.push_back(loaded.at(std::make_pair(filePath, vars[i])));
+  }
+  return tables;
+}
+
+void LookUpTableRegistry::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tables_.clear();
+}
+
+void LookUpTableRegistry::clearCollective(const eckit::mpi::Comm & comm) {
+#ifdef _OPENMP
+  if (omp_in_parallel()) {
+    oops::Log::error() << "ERROR - collective lookup tables cleared inside a parallel region"
+                       << std::endl;
+    throw std::runtime_error("collective lookup table clear inside a parallel region");
+  }
+#endif
+  std::lock_guard<std::mutex> lock(mutex_);
+  collectiveTables_.erase(comm.communicator());
+  const auto windows = windows_.find(comm.communicator());
+  if (windows != windows_.end()) {
+#ifdef VADER_MO_SHARED_TABLES
+    for (const int handle : windows->second) {
+      MPI_Win window = MPI_Win_f2c(handle);
+      MPI_Win_free(&window);
+    }
+#endif
+    windows_.erase(windows);
+  }
+}
+
+LookUpTable LookUpTableRegistry::find(const std::string & filePath,
+                                      const std::string & shortName,
+                                      const std::size_t lookupSize) const {
+  const auto key = std::make_pair(filePath, shortName);
+  LookUpTable table;
+  for (const auto & loaded : collectiveTables_) {
+    const auto found = loaded.second.find(key);
+    if (found != loaded.second.end()) {
+      table = found->second;
+      break;
+    }
+  }
+  if (!table) {
+    const auto found = tables_.find(key);
+    if (found != tables_.end()) table = found->second;
+  }
+  if (table && table.size() != lookupSize) {
+    oops::Log::error() << "ERROR - lookup table " << shortName << " from " << filePath
+                       << " has " << table.size() << " values, " << lookupSize
+                       << " requested" << std::endl;
+    throw std::runtime_error("lookup table size mismatch");
+  }
+  return table;
+}
+
+}  // namespace mo
@@ -0,0 +1,121 @@
+/*
+ * (C) Crown Copyright 2022 Met Office
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "eckit/mpi/Comm.h"
+
+#include "oops/base/Variables.h"
+
+namespace mo {
+
+/// \brief read-only view of a lookup table, shared by all its users; tables read
+///        from a file together share one buffer, kept alive by their views (or,
+///        for MPI shared-memory windows, until the tables are cleared collectively)
+class LookUpTable {
+ public:
+  LookUpTable() : data_(nullptr), size_(0) {}
+  LookUpTable(const std::shared_ptr<const void> & buffer,
+              const double * data, const std::size_t size)
+    : buffer_(buffer), data_(data), size_(size) {}
+
+  const double * data() const { return data_; }
+  std::size_t size() const { return size_; }
+  double operator[](const std::size_t i) const { return data_[i]; }
+  explicit operator bool() const { return data_ != nullptr; }
+
+ private:
+  std::shared_ptr<const void> buffer_;
+  const double * data_;
+  std::size_t size_;
+};
+
+/// \brief LookUpTableRegistry holds the lookup tables read from netcdf files,
+///        keyed by file path and variable name. Each table is read once per
+///        process, on first use, and the same read-only table is then handed out
+///        to every caller. The registry can be used from several threads at once;
+///        reads from the files are serialised.
+///
+///        Given an MPI communicator, tables are instead loaded collectively: they
+///        are read on its first rank only and broadcast to the other ranks. Every
+///        rank of the communicator must make these calls, in the same order, from
+///        one thread and outside any parallel region (not from the kernels of
+///        concurrent recipes). Collectively loaded tables are kept apart from the
+///        others, and are only removed collectively (clearCollective), so that all
+///        the ranks agree on which tables are missing; the calls without a
+///        communicator use them when they are available, and never communicate.
+///        When vader is built with ENABLE_VADER_MO_SHARED_TABLES, the ranks on the
+///        same node also share a single copy of the collectively loaded tables, in
+///        an MPI shared-memory window; there is one window per set of tables loaded
+///        together, freed by clearCollective, which must then be called before MPI is
+///        finalised.
+class LookUpTableRegistry {
+ public:
+  /// \brief registry shared by the whole process
+  static LookUpTableRegistry & global();
+
+  /// \brief table of the variable shortName in the netcdf file filePath, with
+  ///        lookupSize values; the file is only read if the table is not cached
+  LookUpTable get(const std::string & filePath,
+                  const std::string & shortName,
+                  const std::size_t lookupSize);
+
+  /// \brief tables of several variables of the same size in the same file; the
+  ///        tables that are neither cached nor loaded collectively (with any
+  ///        communicator) are read together by this process, opening the file once
+  std::vector<LookUpTable> get(const std::string & filePath,
+                               const oops::Variables & vars,
+                               const std::size_t lookupSize);
+
+  /// \brief as above, loading the tables that comm has not loaded yet on its first
+  ///        rank and broadcasting them to its other ranks (collective over comm,
+  ///        outside parallel regions)
+  std::vector<LookUpTable> get(const std::string & filePath,
+                               const oops::Variables & vars,
+                               const std::size_t lookupSize,
+                               const eckit::mpi::Comm & comm);
+
+  /// \brief removes the tables read by this process alone from the registry, so
+  ///        that they are read again on next use; tables already handed out remain
+  ///        valid, and collectively loaded tables are kept (see clearCollective)
+  void clear();
+
+  /// \brief removes the tables loaded collectively over comm, and frees their
+  ///        shared-memory windows (collective over comm, outside parallel regions,
+  ///        before MPI is finalised); tables already handed out remain valid unless
+  ///        they are held in a window
+  void clearCollective(const eckit::mpi::Comm & comm);
+
+ private:
+  typedef std::map<std::pair<std::string, std::string>, LookUpTable> Tables;
+
+  /// \brief table of a variable if it is loaded collectively or cached, or an empty
+  ///        table; throws if it does not have lookupSize values (mutex_ held)
+  LookUpTable find(const std::string & filePath, const std::string & shortName,
+                   const std::size_t lookupSize) const;
+
+  /// \brief guards the tables
+  mutable std::mutex mutex_;
+  /// \brief serialises the reads from the files (netcdf is not thread-safe)
+  std::mutex readMutex_;
+  /// \brief tables read by this process alone
+  Tables tables_;
+  /// \brief tables loaded collectively, by communicator (Fortran handle)
+  std::map<int, Tables> collectiveTables_;
+  /// \brief shared-memory windows holding collectively loaded tables, by
+  ///        communicator (Fortran handles of both)
+  std::map<int, std::vector<int>> windows_;
+};
+
+}  // namespace mo
@@ -19,6 +19,8 @@
 
 #include "oops/util/Logger.h"
 
+#include "vader/StatsRegistry.h"
+
 using atlas::array::make_view;
 using atlas::idx_t;
 using atlas::util::Config;
@@ -31,23 +33,36 @@ void initField_rank2(atlas::Field & field, const double value_init)
 }
 
 
+template <typename T>
 void setUniformValue_rank2(atlas::Field & field, const double value)
 {
-  auto ds_view = make_view<double, 2>(field);
+  auto ds_view = make_view<T, 2>(field);
 
   ds_view.assign(value);
 }
 
+void setUniformValue_rank2(atlas::Field & field, const double value)
+{
+  functions::dispatchPrecision(field, [&](auto precision) {
+    return setUniformValue_rank2<decltype(precision)>(field, value);
+  });
+}
+
 
-bool evalTotalMassMoistAir(atlas::FieldSet & fields)
+template <typename T>
+bool evalTotalMassMoistAir(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
 {
   oops::Log::trace() << "[evalTotalMassMoistAir()] starting ..." << std::endl;
 
-  const auto ds_m_v  = make_view<const double, 2>(fields["m_v"]);
-  const auto ds_m_ci = make_view<const double, 2>(fields["m_ci"]);
-  const auto ds_m_cl = make_view<const double, 2>(fields["m_cl"]);
-  const auto ds_m_r  = make_view<const double, 2>(fields["m_r"]);
-  auto ds_m_t  = make_view<double, 2>(fields["m_t"]);
+  vader::ScopedKernelTimer timer("mo::evalTotalMassMoistAir", columns);
+  timer.reads(fields, {"m_v", "m_ci", "m_cl", "m_r"})
+       .writes(fields, {"m_t"});
+
+  const auto ds_m_v  = make_view<const T, 2>(fields["m_v"]);
+  const auto ds_m_ci = make_view<const T, 2>(fields["m_ci"]);
+  const auto ds_m_cl = make_view<const T, 2>(fields["m_cl"]);
+  const auto ds_m_r  = make_view<const T, 2>(fields["m_r"]);
+  auto ds_m_t  = make_view<T, 2>(fields["m_t"]);
 
   auto fspace = fields["m_t"].functionspace();
 
@@ -57,27 +72,39 @@ bool evalTotalMassMoistAir(atlas::FieldSet & fields)
   auto conf = Config("levels", fields["m_t"].levels()) |
               Config("include_halo", true);
 
-  functions::parallelFor(fspace, evaluateMt, conf);
+  functions::parallelFor(fspace, columns, evaluateMt, conf);
 
   oops::Log::trace() << "[evalTotalMassMoistAir()] ... exit" << std::endl;
 
   return true;
 }
 
+bool evalTotalMassMoistAir(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
+{
+  return functions::dispatchPrecision(fields["m_t"], [&](auto precision) {
+    return evalTotalMassMoistAir<decltype(precision)>(fields, columns);
+  });
+}
+
 /// \brief function to evaluate the quantity:
 ///   qx = m_x/m_t
 /// where ...
 ///   m_x = [ mv | mci | mcl | m_r ]
 ///   m_t  = total mass of moist air
 ///
-bool evalRatioToMt(atlas::FieldSet & fields, const std::vector<std::string> & vars)
+template <typename T>
+bool evalRatioToMt(atlas::FieldSet & fields, const std::vector<std::string> & vars,
+                   const vader::ColumnSelection & columns)
 {
   oops::Log::trace() << "[evalRatioToMt()] starting ..." << std::endl;
 
+  vader::ScopedKernelTimer timer("mo::evalRatioToMt(" + vars[2] + ")", columns);
+  timer.reads(fields[vars[0]]).reads(fields[vars[1]]).writes(fields[vars[2]]);
+
   // fields[0] = m_x = [ mv | mci | mcl | m_r ]
-  const auto ds_m_x  = make_view<const double, 2>(fields[vars[0]]);
-  const auto ds_m_t  = make_view<const double, 2>(fields[vars[1]]);
-  auto ds_tfield  = make_view<double, 2>(fields[vars[2]]);
+  const auto ds_m_x  = make_view<const T, 2>(fields[vars[0]]);
+  const auto ds_m_t  = make_view<const T, 2>(fields[vars[1]]);
+  auto ds_tfield  = make_view<T, 2>(fields[vars[2]]);
 
   auto fspace = fields[vars[1]].functionspace();
 
@@ -88,70 +115,97 @@ bool evalRatioToMt(atlas::FieldSet & fields, const std::vector<std::string> & va
   auto conf = Config("levels", fields[1].levels()) |
               Config("include_halo", true);
 
-  functions::parallelFor(fspace, evaluateRatioToMt, conf);
+  functions::parallelFor(fspace, columns, evaluateRatioToMt, conf);
 
   oops::Log::trace() << "[evalRatioToMt()] ... exit" << std::endl;
 
   return true;
 }
 
+bool evalRatioToMt(atlas::FieldSet & fields, const std::vector<std::string> & vars,
+                   const vader::ColumnSelection & columns)
+{
+  return functions::dispatchPrecision(fields[vars[2]], [&](auto precision) {
+    return evalRatioToMt<decltype(precision)>(fields, vars, columns);
+  });
+}
 
-bool evalSpecificHumidity(atlas::FieldSet & fields)
+
+bool evalSpecificHumidity(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
 {
   oops::Log::trace() << "[evalSpecificHumidity()] starting ..." << std::endl;
 
   std::vector<std::string> fnames {"m_v", "m_t", "specific_humidity"};
 
-  bool rvalue = evalRatioToMt(fields, fnames);
+  bool rvalue = evalRatioToMt(fields, fnames, columns);
 
   oops::Log::trace() << "[evalSpecificHumidity()] ... exit" << std::endl;
 
   return rvalue;
 }
 
-bool evalRelativeHumidity(atlas::FieldSet & fields)
+template <typename T>
+bool evalRelativeHumidity(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
 {
   oops::Log::trace() << "[evalRelativeHumidity()] starting ..." << std::endl;
 
+  vader::ScopedKernelTimer timer("mo::evalRelativeHumidity", columns);
+  timer.reads(fields, {"specific_humidity", "qsat"})
+       .writes(fields, {"relative_humidity"});
+
   bool cap_super_sat(false);
 
   if (fields["relative_humidity"].metadata().has("cap_super_sat")) {
     fields["relative_humidity"].metadata().get("cap_super_sat", cap_super_sat);
   }
 
-  const auto qView = make_view<const double, 2>(fields["specific_humidity"]);
-  const auto qsatView = make_view<const double, 2>(fields["qsat"]);
-  auto rhView = make_view<double, 2>(fields["relative_humidity"]);
+  const auto qView = make_view<const T, 2>(fields["specific_humidity"]);
+  const auto qsatView = make_view<const T, 2>(fields["qsat"]);
+  auto rhView = make_view<T, 2>(fields["relative_humidity"]);
 
   auto conf = Config("levels", fields["relative_humidity"].levels()) |
               Config("include_halo", true);
 
   auto evaluateRH = [&] (idx_t i, idx_t j) {
-    rhView(i, j) = fmax(qView(i, j) / qsatView(i, j) * 100.0, 0.0);
-    rhView(i, j) = (cap_super_sat && (rhView(i, j) > 100.0)) ? 100.0 : rhView(i, j);
+    const double rh = fmax(qView(i, j) / qsatView(i, j) * 100.0, 0.0);
+    rhView(i, j) = (cap_super_sat && (rh > 100.0)) ? 100.0 : rh;
   };
 
   auto fspace = fields["relative_humidity"].functionspace();
 
-  functions::parallelFor(fspace, evaluateRH, conf);
+  functions::parallelFor(fspace, columns, evaluateRH, conf);
 
   oops::Log::trace() << "[evalRelativeHumidity()] ... exit" << std::endl;
 
   return true;
 }
 
-bool evalTotalRelativeHumidity(atlas::FieldSet & fields)
+bool evalRelativeHumidity(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
+{
+  return functions::dispatchPrecision(fields["relative_humidity"], [&](auto precision) {
+    return evalRelativeHumidity<decltype(precision)>(fields, columns);
+  });
+}
+
+template <typename T>
+bool evalTotalRelativeHumidity(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
 {
   oops::Log::trace() << "[evalTotalRelativeHumidity()] starting ..." << std::endl;
 
-  const auto qView = make_view<const double, 2>(fields["specific_humidity"]);
-  const auto qclView = make_view<const double, 2>
+  vader::ScopedKernelTimer timer("mo::evalTotalRelativeHumidity", columns);
+  timer.reads(fields, {"specific_humidity",
+                       "mass_content_of_cloud_liquid_water_in_atmosphere_layer",
+                       "mass_content_of_cloud_ice_in_atmosphere_layer", "qrain", "qsat"})
+       .writes(fields, {"rht"});
+
+  const auto qView = make_view<const T, 2>(fields["specific_humidity"]);
+  const auto qclView = make_view<const T, 2>
                  (fields["mass_content_of_cloud_liquid_water_in_atmosphere_layer"]);
-  const auto qciView = make_view<const double, 2>
+  const auto qciView = make_view<const T, 2>
                  (fields["mass_content_of_cloud_ice_in_atmosphere_layer"]);
-  const auto qrainView = make_view<const double, 2>(fields["qrain"]);
-  const auto qsatView = make_view<const double, 2>(fields["qsat"]);
-  auto rhtView = make_view<double, 2>(fields["rht"]);
+  const auto qrainView = make_view<const T, 2>(fields["qrain"]);
+  const auto qsatView = make_view<const T, 2>(fields["qsat"]);
+  auto rhtView = make_view<T, 2>(fields["rht"]);
 
   auto conf = Config("levels", fields["rht"].levels()) |
               Config("include_halo", true);
@@ -168,20 +222,27 @@ bool evalTotalRelativeHumidity(atlas::FieldSet & fields)
 
   auto fspace = fields["rht"].functionspace();
 
-  functions::parallelFor(fspace, evaluateRHT, conf);
+  functions::parallelFor(fspace, columns, evaluateRHT, conf);
 
   oops::Log::trace() << "[evalTotalRelativeHumidity()] ... exit" << std::endl;
 
   return true;
 }
 
-bool evalMassCloudIce(atlas::FieldSet & fields)
+bool evalTotalRelativeHumidity(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
+{
+  return functions::dispatchPrecision(fields["rht"], [&](auto precision) {
+    return evalTotalRelativeHumidity<decltype(precision)>(fields, columns);
+  });
+}
+
+bool evalMassCloudIce(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
 {
   oops::Log::trace() << "[evalMassCloudIce()] starting ..." << std::endl;
 
   std::vector<std::string> fnames {"m_ci", "m_t",
                                    "mass_content_of_cloud_ice_in_atmosphere_layer"};
-  bool rvalue = evalRatioToMt(fields, fnames);
+  bool rvalue = evalRatioToMt(fields, fnames, columns);
 
   oops::Log::trace() << "[evalMassCloudIce()] ... exit" << std::endl;
 
@@ -189,13 +250,13 @@ bool evalMassCloudIce(atlas::FieldSet & fields)
 }
 
 
-bool evalMassCloudLiquid(atlas::FieldSet & fields)
+bool evalMassCloudLiquid(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
 {
   oops::Log::trace() << "[evalMassCloudLiquid()] starting ..." << std::endl;
 
   std::vector<std::string> fnames {"m_cl", "m_t",
                                    "mass_content_of_cloud_liquid_water_in_atmosphere_layer"};
-  bool rvalue = evalRatioToMt(fields, fnames);
+  bool rvalue = evalRatioToMt(fields, fnames, columns);
 
   oops::Log::trace() << "[evalMassCloudLiquid()] ... exit" << std::endl;
 
@@ -203,12 +264,12 @@ bool evalMassCloudLiquid(atlas::FieldSet & fields)
 }
 
 
-bool evalMassRain(atlas::FieldSet & fields)
+bool evalMassRain(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
 {
   oops::Log::trace() << "[evalMassRain()] starting ..." << std::endl;
 
   std::vector<std::string> fnames {"m_r", "m_t", "qrain"};
-  bool rvalue = evalRatioToMt(fields, fnames);
+  bool rvalue = evalRatioToMt(fields, fnames, columns);
 
   oops::Log::trace() << "[evalMassRain()] ... exit" << std::endl;
 
@@ -216,13 +277,18 @@ bool evalMassRain(atlas::FieldSet & fields)
 }
 
 
-bool evalAirTemperature(atlas::FieldSet & fields)
+template <typename T>
+bool evalAirTemperature(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
 {
   oops::Log::trace() << "[evalAirTemperature()] starting ..." << std::endl;
 
-  const auto ds_theta  = make_view<const double, 2>(fields["potential_temperature"]);
-  const auto ds_exner = make_view<const double, 2>(fields["exner"]);
-  auto ds_atemp = make_view<double, 2>(fields["air_temperature"]);
+  vader::ScopedKernelTimer timer("mo::evalAirTemperature", columns);
+  timer.reads(fields, {"potential_temperature", "exner"})
+       .writes(fields, {"air_temperature"});
+
+  const auto ds_theta  = make_view<const T, 2>(fields["potential_temperature"]);
+  const auto ds_exner = make_view<const T, 2>(fields["exner"]);
+  auto ds_atemp = make_view<T, 2>(fields["air_temperature"]);
 
   auto fspace = fields["air_temperature"].functionspace();
 
@@ -232,24 +298,36 @@ bool evalAirTemperature(atlas::FieldSet & fields)
   auto conf = Config("levels", fields["air_temperature"].levels()) |
               Config("include_halo", true);
 
-  functions::parallelFor(fspace, evaluateAirTemp, conf);
+  functions::parallelFor(fspace, columns, evaluateAirTemp, conf);
 
   oops::Log::trace() << "[evalAirTemperature()] ... exit" << std::endl;
 
   return true;
 }
 
+bool evalAirTemperature(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
+{
+  return functions::dispatchPrecision(fields["air_temperature"], [&](auto precision) {
+    return evalAirTemperature<decltype(precision)>(fields, columns);
+  });
+}
+
 
 
 
 
-bool evalSpecificHumidityFromRH_2m(atlas::FieldSet & fields)
+template <typename T>
+bool evalSpecificHumidityFromRH_2m(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
 {
   oops::Log::trace() << "[evalSpecificHumidityFromRH_2m()] starting ..." << std::endl;
 
-  const auto ds_qsat = make_view<const double, 2>(fields["qsat"]);
-  const auto ds_rh = make_view<const double, 2>(fields["relative_humidity_2m"]);
-  auto ds_q2m = make_view<double, 2>(fields["specific_humidity_at_two_meters_above_surface"]);
+  vader::ScopedKernelTimer timer("mo::evalSpecificHumidityFromRH_2m", columns);
+  timer.reads(fields, {"qsat", "relative_humidity_2m"})
+       .writes(fields, {"specific_humidity_at_two_meters_above_surface"});
+
+  const auto ds_qsat = make_view<const T, 2>(fields["qsat"]);
+  const auto ds_rh = make_view<const T, 2>(fields["relative_humidity_2m"]);
+  auto ds_q2m = make_view<T, 2>(fields["specific_humidity_at_two_meters_above_surface"]);
 
   auto fspace = fields["specific_humidity_at_two_meters_above_surface"].functionspace();
 
@@ -260,18 +338,32 @@ bool evalSpecificHumidityFromRH_2m(atlas::FieldSet & fields)
     fields["specific_humidity_at_two_meters_above_surface"].levels()) |
               Config("include_halo", true);
 
-  functions::parallelFor(fspace, evaluateSpecificHumidity_2m, conf);
+  functions::parallelFor(fspace, columns, evaluateSpecificHumidity_2m, conf);
 
   oops::Log::trace() << "[evalSpecificHumidityFromRH_2m()] ... exit" << std::endl;
 
   return true;
 }
 
+bool evalSpecificHumidityFromRH_2m(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
+{
+  return functions::dispatchPrecision(
+      fields["specific_humidity_at_two_meters_above_surface"], [&](auto precision) {
+    return evalSpecificHumidityFromRH_2m<decltype(precision)>(fields, columns);
+  });
+}
+
 
-bool evalParamAParamB(atlas::FieldSet & fields)
+template <typename T>
+bool evalParamAParamB(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
 {
   oops::Log::trace() << "[evalParamAParamB2()] starting ..." << std::endl;
 
+  vader::ScopedKernelTimer timer("mo::evalParamAParamB", columns);
+  timer.reads(fields, {"height", "height_levels", "air_pressure_levels_minus_one",
+                       "specific_humidity"})
+       .writes(fields, {"param_a", "param_b"});
+
   std::size_t blindex;
   if (!fields["height"].metadata().has("boundary_layer_index")) {
     oops::Log::error() << "ERROR - data validation failed "
@@ -280,37 +372,42 @@ bool evalParamAParamB(atlas::FieldSet & fields)
   }
   fields["height"].metadata().get("boundary_layer_index", blindex);
 
-  const auto heightView = make_view<const double, 2>(fields["height"]);
-  const auto heightLevelsView = make_view<const double, 2>(fields["height_levels"]);
-  const auto pressureLevelsView = make_view<const double, 2>
+  const auto heightView = make_view<const T, 2>(fields["height"]);
+  const auto heightLevelsView = make_view<const T, 2>(fields["height_levels"]);
+  const auto pressureLevelsView = make_view<const T, 2>
       (fields["air_pressure_levels_minus_one"]);
-  const auto specificHumidityView = make_view<const double, 2>(fields["specific_humidity"]);
-  auto param_aView = make_view<double, 2>(fields["param_a"]);
-  auto param_bView = make_view<double, 2>(fields["param_b"]);
-
-  // temperature at level above boundary layer
-  double t_bl;
-  // temperature at model surface height
-  double t_msh;
+  const auto specificHumidityView = make_view<const T, 2>(fields["specific_humidity"]);
+  auto param_aView = make_view<T, 2>(fields["param_a"]);
+  auto param_bView = make_view<T, 2>(fields["param_b"]);
 
   double exp_pmsh = constants::Lclr * constants::rd / constants::grav;
 
-  for (idx_t jn = 0; jn < param_aView.shape(0); ++jn) {
-    t_bl = (-constants::grav / constants::rd) *
+  columns.forEach(param_aView.shape(0), [&](idx_t jn) {
+    // temperature at level above boundary layer
+    double t_bl = (-constants::grav / constants::rd) *
            (heightLevelsView(jn, blindex + 1) - heightLevelsView(jn, blindex)) /
            log(pressureLevelsView(jn, blindex + 1) / pressureLevelsView(jn, blindex));
 
     t_bl = t_bl / (1.0 + constants::c_virtual * specificHumidityView(jn, blindex));
 
-    t_msh = t_bl + constants::Lclr * (heightView(jn, blindex) - heightLevelsView(jn, 0));
+    // temperature at model surface height
+    const double t_msh = t_bl + constants::Lclr *
+                         (heightView(jn, blindex) - heightLevelsView(jn, 0));
 
     param_aView(jn, 0) = heightLevelsView(jn, 0) + t_msh / constants::Lclr;
     param_bView(jn, 0) = t_msh / (pow(pressureLevelsView(jn, 0), exp_pmsh) * constants::Lclr);
-  }
+  });
 
   oops::Log::trace() << "[evalParamAParamB()] ... exit" << std::endl;
 
   return true;
 }
 
+bool evalParamAParamB(atlas::FieldSet & fields, const vader::ColumnSelection & columns)
+{
+  return functions::dispatchPrecision(fields["param_a"], [&](auto precision) {
+    return evalParamAParamB<decltype(precision)>(fields, columns);
+  });
+}
+
 }  // namespace mo
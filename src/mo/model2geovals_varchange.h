@@ -9,6 +9,8 @@
 
 #include "atlas/field.h"
 
+#include "vader/ColumnSelection.h"
+
 
 /// \brief ++ Variable Tranforms Repository ++
 ///
@@ -26,6 +28,10 @@
 /// This is only a temporary repository. In the long term, the Variable Transforms will be
 /// stored and processed by the VAriable DErivation Repository (VADER) system.
 ///
+/// Only the columns selected by the optional ColumnSelection argument of the evaluation
+/// functions are computed; by default, all of them are. The functions are evaluated in
+/// the precision (real32 or real64) of the fields they are given.
+///
 
 
 namespace mo {
@@ -51,7 +57,8 @@ void setUniformValue_rank2(atlas::Field & field, const double value);
 ///   m_cl = mixing ratio of cloud liquid
 ///   m_r  = mixing ratio of rain
 ///
-bool evalTotalMassMoistAir(atlas::FieldSet & fields);
+bool evalTotalMassMoistAir(atlas::FieldSet & fields,
+                           const vader::ColumnSelection & columns = vader::ColumnSelection());
 
 /// \brief function to evaluate the quantity:
 ///   qx = m_x/m_t
@@ -68,7 +75,8 @@ bool evalRatioToMt(atlas::FieldSet & fields);
 ///   m_v  = mixing ratio of water vapour
 ///   m_t  = total mass of moist air
 ///
-bool evalSpecificHumidity(atlas::FieldSet & fields);
+bool evalSpecificHumidity(atlas::FieldSet & fields,
+                          const vader::ColumnSelection & columns = vader::ColumnSelection());
 
 /// \brief function to evaluate the 'relative humidity':
 ///   rh = q/qsat*100
@@ -78,7 +86,8 @@ bool evalSpecificHumidity(atlas::FieldSet & fields);
 ///
 /// Note that we have a bool metadata switch that we need here "cap_super_sat"
 /// If it is not present then we assume that it is false (which is the default)
-bool evalRelativeHumidity(atlas::FieldSet & fields);
+bool evalRelativeHumidity(atlas::FieldSet & fields,
+                          const vader::ColumnSelection & columns = vader::ColumnSelection());
 
 /// \brief function to evaluate the 'total relative humidity':
 ///   rh = (q+qcl+qci+qrain)/qsat*100
@@ -89,7 +98,8 @@ bool evalRelativeHumidity(atlas::FieldSet & fields);
 ///   qrain = specific rain
 ///   qsat  = saturated specific humidity
 ///
-bool evalTotalRelativeHumidity(atlas::FieldSet & fields);
+bool evalTotalRelativeHumidity(atlas::FieldSet & fields,
+                               const vader::ColumnSelection & columns = vader::ColumnSelection());
 
 /// \brief function to evaluate the 'mass content of cloud ice' in atmosphere layer:
 ///   qci = m_ci/m_t
@@ -97,7 +107,8 @@ bool evalTotalRelativeHumidity(atlas::FieldSet & fields);
 ///   m_ci = mixing ratio of cloud ice
 ///   m_t  = total mass of moist air
 ///
-bool evalMassCloudIce(atlas::FieldSet & fields);
+bool evalMassCloudIce(atlas::FieldSet & fields,
+                      const vader::ColumnSelection & columns = vader::ColumnSelection());
 
 
 /// \brief function to evaluate the 'mass content of liquid water' in atmosphere layer:
@@ -106,7 +117,8 @@ bool evalMassCloudIce(atlas::FieldSet & fields);
 ///   m_cl = mixing ratio of cloud liquid
 ///   m_t  = total mass of moist air
 ///
-bool evalMassCloudLiquid(atlas::FieldSet & fields);
+bool evalMassCloudLiquid(atlas::FieldSet & fields,
+                         const vader::ColumnSelection & columns = vader::ColumnSelection());
 
 
 /// \brief function to evaluate the 'mass content of rain' in atmosphere layer:
@@ -115,7 +127,8 @@ bool evalMassCloudLiquid(atlas::FieldSet & fields);
 ///   m_r = mixing ratio of rain
 ///   m_t = total mass of moist air
 ///
-bool evalMassRain(atlas::FieldSet & fields);
+bool evalMassRain(atlas::FieldSet & fields,
+                  const vader::ColumnSelection & columns = vader::ColumnSelection());
 
 
 /// \brief function to evaluate the 'air temperature':
@@ -127,7 +140,8 @@ bool evalMassRain(atlas::FieldSet & fields);
 /// note that ...
 /// 'theta' and 'exner' are on the same levels
 ///
-bool evalAirTemperature(atlas::FieldSet & fields);
+bool evalAirTemperature(atlas::FieldSet & fields,
+                        const vader::ColumnSelection & columns = vader::ColumnSelection());
 
 
 /// \brief function to evaluate the 'specific humidity at two meters above surface':
@@ -137,7 +151,9 @@ bool evalAirTemperature(atlas::FieldSet & fields);
 ///   rh   = relative humidity at two meters above surface
 ///   qsat = saturation specific humidity
 ///
-bool evalSpecificHumidityFromRH_2m(atlas::FieldSet & fields);
+bool evalSpecificHumidityFromRH_2m(atlas::FieldSet & fields,
+                                   const vader::ColumnSelection & columns =
+                                       vader::ColumnSelection());
 
 
 /// \brief function to evaluate 'param_a' and 'param_b';
@@ -158,6 +174,7 @@ bool evalSpecificHumidityFromRH_2m(atlas::FieldSet & fields);
 ///     pressure_levels_minus_one = pressure on rho model levels
 ///     specific_humidity
 ///
-bool evalParamAParamB(atlas::FieldSet & fields);
+bool evalParamAParamB(atlas::FieldSet & fields,
+                      const vader::ColumnSelection & columns = vader::ColumnSelection());
 
 }  // namespace mo
@@ -0,0 +1,111 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vader/ChangeVarPlan.h"
+#include "vader/RecipeBase.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief Build Dependency Graph
+*
+* \details Links each step to the steps that produce its ingredients. The planner
+* always adds the recipes for the ingredients of a recipe before the recipe itself,
+* so the steps are already in a valid (topological) execution order and a step can
+* only depend on steps that come before it.
+*
+* When fuseColumnKernels is set, runs of consecutive steps whose recipes have column
+* kernels are grouped into a single (fused) stage; every other step is a stage of its
+* own. As a stage is a contiguous run of steps, the stages are in a valid execution
+* order too, and the steps of a fused stage only depend on earlier steps of the same
+* stage or on earlier stages.
+*/
+void ChangeVarPlan::buildDependencyGraph(bool fuseColumnKernels) {
+    std::unordered_map<std::string, std::size_t> producer;
+    std::vector<std::size_t> stageOf(steps_.size());
+    bool previousFusible = false;
+    stages_.clear();
+    for (std::size_t i = 0; i < steps_.size(); ++i) {
+        Step & step = steps_[i];
+        step.dependencies.clear();
+        step.dependents.clear();
+        for (const auto & ingredient : step.recipe->ingredients()) {
+            auto it = producer.find(ingredient);
+            if (it != producer.end()) {
+                step.dependencies.push_back(it->second);
+                steps_[it->second].dependents.push_back(i);
+            }
+        }
+        producer[step.variable] = i;
+
+        const bool fusible = fuseColumnKernels && step.recipe->hasColumnKernel();
+        if (!fusible || !previousFusible) stages_.emplace_back();
+        stages_.back().steps.push_back(i);
+        previousFusible = fusible;
+        stageOf[i] = stages_.size() - 1;
+    }
+
+    std::vector<std::size_t> depth(stages_.size(), 0);
+    std::vector<std::size_t> width;
+    for (std::size_t s = 0; s < stages_.size(); ++s) {
+        Stage & stage = stages_[s];
+        for (auto i : stage.steps) {
+            for (auto dependency : steps_[i].dependencies) {
+                const std::size_t d = stageOf[dependency];
+                if (d == s || std::find(stage.dependencies.begin(), stage.dependencies.end(), d)
+                              != stage.dependencies.end()) continue;
+                stage.dependencies.push_back(d);
+                stages_[d].dependents.push_back(s);
+                depth[s] = std::max(depth[s], depth[d] + 1);
+            }
+        }
+        if (depth[s] >= width.size()) width.resize(depth[s] + 1, 0);
+        ++width[depth[s]];
+    }
+    maxConcurrency_ = width.empty() ? 0 : *std::max_element(width.begin(), width.end());
+
+    std::vector<int> liveChange(stages_.size() + 1, 0);
+    for (std::size_t i = 0; i < steps_.size(); ++i) {
+        if (!steps_[i].scratch) continue;
+        std::size_t lastUse = stageOf[i];
+        for (auto dependent : steps_[i].dependents) lastUse = std::max(lastUse, stageOf[dependent]);
+        ++liveChange[stageOf[i]];
+        --liveChange[lastUse + 1];
+    }
+    int live = 0;
+    maxLiveScratch_ = 0;
+    for (std::size_t s = 0; s < stages_.size(); ++s) {
+        live += liveChange[s];
+        maxLiveScratch_ = std::max(maxLiveScratch_, static_cast<std::size_t>(live));
+    }
+}
+// ------------------------------------------------------------------------------------------------
+void ChangeVarPlan::print(std::ostream & os) const {
+    os << "ChangeVarPlan with " << steps_.size() << " step(s)";
+    for (const auto & step : steps_) {
+        os << std::endl << "  " << step.variable << (step.scratch ? " (scratch)" : "") <<
+            " <- " << step.recipe->name();
+        if (!step.dependencies.empty()) {
+            os << " (after step";
+            for (auto dependency : step.dependencies) os << " " << dependency;
+            os << ")";
+        }
+    }
+    for (const auto & stage : stages_) {
+        if (!stage.fused()) continue;
+        os << std::endl << "  fused steps";
+        for (auto i : stage.steps) os << " " << i;
+    }
+}
+
+}  // namespace vader
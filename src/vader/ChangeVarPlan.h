@@ -0,0 +1,96 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_CHANGEVARPLAN_H_
+#define SRC_VADER_CHANGEVARPLAN_H_
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "oops/base/Variables.h"
+#include "oops/util/Printable.h"
+
+namespace vader {
+
+class RecipeBase;
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief ChangeVarPlan class holds a compiled recipe execution plan
+ *
+ *  \details A ChangeVarPlan is created by Vader::compile for a given list of
+ *           allocated field names and a list of variables that need to be
+ *           populated. It holds the ordered list of recipes Vader will execute,
+ *           as pointers resolved against the Vader cookbook, so callers that
+ *           change variables many times with the same field layout only pay for
+ *           planning once.
+ *
+ *           A plan is immutable once compiled and is only valid for the lifetime
+ *           of the Vader object that compiled it.
+ */
+class ChangeVarPlan : public util::Printable {
+ public:
+    /// A single entry in the plan: the variable to populate and the recipe that
+    /// populates it. The recipe is owned by the Vader cookbook. The dependencies
+    /// and dependents are indices of the other steps of the plan that produce this
+    /// step's ingredients, and that use this step's variable as an ingredient.
+    /// Scratch steps produce intermediates that are not allocated in the FieldSet:
+    /// Vader allocates them, and releases them once all their dependents have run.
+    struct Step {
+        std::string variable;
+        RecipeBase * recipe;
+        bool scratch;
+        std::vector<std::size_t> dependencies;
+        std::vector<std::size_t> dependents;
+    };
+    /// A group of consecutive steps that are executed together. Stages with more
+    /// than one step are fused: all their recipes have column kernels and are
+    /// evaluated column by column in a single sweep over the fields. The
+    /// dependencies and dependents are indices of other stages.
+    struct Stage {
+        std::vector<std::size_t> steps;
+        std::vector<std::size_t> dependencies;
+        std::vector<std::size_t> dependents;
+        bool fused() const {return steps.size() > 1;}
+    };
+
+    ChangeVarPlan() = default;
+
+    /// Ordered list of recipes to execute
+    const std::vector<Step> & steps() const {return steps_;}
+    /// Variables the plan will populate
+    const oops::Variables & producedVars() const {return producedVars_;}
+    /// Names of the fields the plan was compiled against
+    const std::vector<std::string> & fieldNames() const {return fieldNames_;}
+    bool empty() const {return steps_.empty();}
+    std::size_t size() const {return steps_.size();}
+    /// Steps grouped into the units the executor schedules, in execution order
+    const std::vector<Stage> & stages() const {return stages_;}
+    /// Largest number of stages that do not depend on each other (the widest level of
+    /// the dependency graph), i.e. how many stages can usefully run at the same time
+    std::size_t maxConcurrency() const {return maxConcurrency_;}
+    /// Largest number of scratch fields alive at the same time when the stages are
+    /// executed in order
+    std::size_t maxLiveScratch() const {return maxLiveScratch_;}
+
+ private:
+    friend class Vader;
+
+    void buildDependencyGraph(bool fuseColumnKernels);
+    void print(std::ostream &) const override;
+
+    std::vector<Step> steps_;
+    std::vector<Stage> stages_;
+    std::size_t maxConcurrency_ = 0;
+    std::size_t maxLiveScratch_ = 0;
+    oops::Variables producedVars_;
+    std::vector<std::string> fieldNames_;
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_CHANGEVARPLAN_H_
@@ -0,0 +1,71 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <algorithm>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "atlas/array.h"
+#include "oops/util/abor1_cpp.h"
+#include "oops/util/Logger.h"
+#include "vader/ColumnSelection.h"
+
+namespace vader {
+
+namespace {
+
+template <typename T>
+std::vector<atlas::idx_t> maskedColumns(const atlas::Field & mask) {
+    const auto maskView = atlas::array::make_view<const T, 2>(mask);
+    std::vector<atlas::idx_t> columns;
+    for (atlas::idx_t jn = 0; jn < maskView.shape(0); ++jn) {
+        if (maskView(jn, 0) != 0) columns.push_back(jn);
+    }
+    return columns;
+}
+
+}  // namespace
+
+// ------------------------------------------------------------------------------------------------
+ColumnSelection::ColumnSelection(std::vector<atlas::idx_t> columns)
+    : all_(false), columns_(std::move(columns)) {
+    std::sort(columns_.begin(), columns_.end());
+    columns_.erase(std::unique(columns_.begin(), columns_.end()), columns_.end());
+    if (!columns_.empty() && columns_.front() < 0) {
+        oops::Log::error() << "ColumnSelection: negative column index " << columns_.front() <<
+            std::endl;
+        ABORT("ColumnSelection: negative column index");
+    }
+}
+// ------------------------------------------------------------------------------------------------
+ColumnSelection::ColumnSelection(const atlas::Field & mask) : all_(false) {
+    if (mask.datatype().kind() == atlas::array::DataType::kind<double>()) {
+        columns_ = maskedColumns<double>(mask);
+    } else if (mask.datatype().kind() == atlas::array::DataType::kind<int>()) {
+        columns_ = maskedColumns<int>(mask);
+    } else {
+        oops::Log::error() << "ColumnSelection: mask field " << mask.name() <<
+            " has unsupported data type " << mask.datatype().str() << std::endl;
+        ABORT("ColumnSelection: unsupported mask data type");
+    }
+}
+// ------------------------------------------------------------------------------------------------
+atlas::idx_t ColumnSelection::size(atlas::idx_t totalColumns) const {
+    if (all_) return totalColumns;
+    return std::lower_bound(columns_.begin(), columns_.end(), totalColumns) - columns_.begin();
+}
+// ------------------------------------------------------------------------------------------------
+void ColumnSelection::print(std::ostream & os) const {
+    if (all_) {
+        os << "ColumnSelection: all columns";
+    } else {
+        os << "ColumnSelection: " << columns_.size() << " column(s)";
+    }
+}
+
+}  // namespace vader
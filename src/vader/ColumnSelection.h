@@ -0,0 +1,71 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_COLUMNSELECTION_H_
+#define SRC_VADER_COLUMNSELECTION_H_
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "atlas/field/Field.h"
+#include "oops/util/Printable.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief ColumnSelection class holds the columns (horizontal points) to compute
+ *
+ *  \details Callers that only need derived variables at some columns of their fields
+ *           (e.g. the columns close to observations) pass a ColumnSelection to
+ *           Vader::changeVar. It is handed to every recipe executed, and can be passed
+ *           to the mo functions, which then only compute the selected columns and leave
+ *           the other values of the fields they populate untouched.
+ *
+ *           A default constructed ColumnSelection selects every column. Otherwise the
+ *           selection is a sorted list of column indices, given explicitly or as the
+ *           columns where a mask field is non-zero.
+ */
+class ColumnSelection : public util::Printable {
+ public:
+    /// Selects every column
+    ColumnSelection() = default;
+    /// Selects the columns with the given indices, which must not be negative. Indices
+    /// beyond the number of columns of a field are ignored for that field.
+    explicit ColumnSelection(std::vector<atlas::idx_t> columns);
+    /// Selects the columns where the first level of a (double or int) mask field is
+    /// non-zero
+    explicit ColumnSelection(const atlas::Field & mask);
+
+    /// True if every column is selected
+    bool all() const {return all_;}
+    /// Sorted indices of the selected columns (empty if all() is true)
+    const std::vector<atlas::idx_t> & columns() const {return columns_;}
+    /// Number of columns selected among the first totalColumns ones
+    atlas::idx_t size(atlas::idx_t totalColumns) const;
+
+    /// Calls f(jn) for every selected column jn among the first totalColumns ones
+    template <typename F>
+    void forEach(atlas::idx_t totalColumns, const F & f) const {
+        if (all_) {
+            for (atlas::idx_t jn = 0; jn < totalColumns; ++jn) f(jn);
+            return;
+        }
+        const atlas::idx_t n = size(totalColumns);
+        for (atlas::idx_t k = 0; k < n; ++k) f(columns_[k]);
+    }
+
+ private:
+    void print(std::ostream &) const override;
+
+    bool all_ = true;
+    std::vector<atlas::idx_t> columns_;
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_COLUMNSELECTION_H_
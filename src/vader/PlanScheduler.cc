@@ -0,0 +1,90 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+
+#include "oops/util/Logger.h"
+#include "vader/PlanScheduler.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+PlanScheduler::PlanScheduler(const ChangeVarPlan & plan, const StageFunction & stageFunction)
+    : plan_(plan), stageFunction_(stageFunction),
+      pendingDependencies_(new std::atomic<std::size_t>[plan.stages().size()]),
+      failed_(false), innerThreads_(1) {}
+// ------------------------------------------------------------------------------------------------
+void PlanScheduler::runSequential() {
+    for (const auto & stage : plan_.stages()) {
+        stageFunction_(stage);
+    }
+}
+// ------------------------------------------------------------------------------------------------
+void PlanScheduler::runConcurrent() {
+#ifdef _OPENMP
+    const int maxThreads = omp_get_max_threads();
+    const int outerThreads = std::min(maxThreads, static_cast<int>(plan_.maxConcurrency()));
+    // Nothing to overlap, already inside somebody else's parallel region, or nested
+    // parallelism disabled by the application (the recipes' parallel loops would then run
+    // on one thread each). The nesting level is the application's to set, not ours.
+    if (outerThreads < 2 || omp_in_parallel() || omp_get_max_active_levels() < 2) {
+        runSequential();
+        return;
+    }
+    const auto & stages = plan_.stages();
+    oops::Log::debug() << "PlanScheduler running " << stages.size() << " stages on " <<
+        outerThreads << " threads" << std::endl;
+
+    innerThreads_ = std::max(1, maxThreads / outerThreads);
+    for (std::size_t i = 0; i < stages.size(); ++i) {
+        pendingDependencies_[i] = stages[i].dependencies.size();
+    }
+#pragma omp parallel num_threads(outerThreads)
+#pragma omp single
+    {
+        for (std::size_t i = 0; i < stages.size(); ++i) {
+            if (stages[i].dependencies.empty()) {
+#pragma omp task firstprivate(i)
+                runStage(i);
+            }
+        }
+    }
+
+    if (error_) std::rethrow_exception(error_);
+#else
+    runSequential();
+#endif
+}
+// ------------------------------------------------------------------------------------------------
+void PlanScheduler::runStage(std::size_t i) {
+#ifdef _OPENMP
+    // Size of the teams of the parallel loops nested inside this stage
+    omp_set_num_threads(innerThreads_);
+#endif
+    const ChangeVarPlan::Stage & stage = plan_.stages()[i];
+    if (!failed_) {
+        try {
+            stageFunction_(stage);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex_);
+            if (!error_) error_ = std::current_exception();
+            failed_ = true;
+        }
+    }
+    for (std::size_t next : stage.dependents) {
+        if (pendingDependencies_[next].fetch_sub(1) == 1) {
+#pragma omp task firstprivate(next)
+            runStage(next);
+        }
+    }
+}
+
+}  // namespace vader
@@ -0,0 +1,67 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_PLANSCHEDULER_H_
+#define SRC_VADER_PLANSCHEDULER_H_
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <boost/noncopyable.hpp>
+
+#include "vader/ChangeVarPlan.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief PlanScheduler class runs the stages of a ChangeVarPlan
+ *
+ *  \details The scheduler walks the dependency graph of a compiled plan and calls
+ *           the supplied function once for every stage, never before all the stages
+ *           producing that stage's ingredients have completed.
+ *
+ *           In concurrent mode each stage is an OpenMP task: a stage's task is
+ *           spawned by whichever task completes its last dependency, and idle
+ *           threads of the team take (steal) ready tasks from the OpenMP runtime.
+ *           The threads not needed for the outer team are handed down to each task,
+ *           so the parallel loops inside the recipes keep running in parallel.
+ *           This needs nested parallelism (OMP_MAX_ACTIVE_LEVELS of at least 2), which
+ *           the scheduler never changes itself: without it the stages are run
+ *           sequentially instead.
+ *
+ *           The first exception thrown by a stage is rethrown once the scheduler
+ *           has finished; stages that have not started by then are skipped.
+ */
+class PlanScheduler : private boost::noncopyable {
+ public:
+    typedef std::function<void(const ChangeVarPlan::Stage &)> StageFunction;
+
+    PlanScheduler(const ChangeVarPlan &, const StageFunction &);
+
+    /// Runs the stages one after the other, in plan order
+    void runSequential();
+    /// Runs the stages that do not depend on each other concurrently
+    void runConcurrent();
+
+ private:
+    void runStage(std::size_t);
+
+    const ChangeVarPlan & plan_;
+    const StageFunction stageFunction_;
+    std::unique_ptr<std::atomic<std::size_t>[]> pendingDependencies_;
+    std::atomic<bool> failed_;
+    std::exception_ptr error_;
+    std::mutex errorMutex_;
+    int innerThreads_;
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_PLANSCHEDULER_H_
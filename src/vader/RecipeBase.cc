@@ -8,6 +8,7 @@
 #include "vader/RecipeBase.h"
 
 #include <map>
+#include <utility>
 #include <vector>
 
 #include "oops/util/abor1_cpp.h"
@@ -71,6 +72,100 @@ RecipeFactory::createParameters(const std::string &name) {
   return it->second->makeParameters();
 }
 
+// ------------------------------------------------------------------------------------------------
+
+double RecipeCost::weight() const {
+  const double flopsPerByte = 8.0;
+  const double vectorWidth = 4.0;
+  return bytes + flops * (columnScan ? vectorWidth : 1.0) / flopsPerByte;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+RecipeCost RecipeBase::cost() const {
+  return RecipeCost{1.0, sizeof(double) * (ingredients().size() + 1.0), false};
+}
+
+// ------------------------------------------------------------------------------------------------
+
+RecipeBase::SetupLock RecipeBase::ensureSetup(atlas::FieldSet & afieldset) {
+  std::vector<IngredientGeometry> geometry;
+  if (requiresSetup()) {
+    for (const auto & ingredient : ingredients()) {
+      if (!afieldset.has_field(ingredient)) continue;
+      const atlas::Field field = afieldset.field(ingredient);
+      geometry.push_back({field.functionspace().get(), field.shape(0), field.levels(),
+                          static_cast<int>(field.datatype().kind())});
+    }
+  }
+  std::unique_lock<std::mutex> lock(setupMutex_);
+  if (requiresSetup() && !(isSetup_ && geometry == setupGeometry_)) {
+    // Executions using the current setup must finish first
+    setupIdle_.wait(lock, [this] { return executions_ == 0; });
+    if (!(isSetup_ && geometry == setupGeometry_)) {
+      oops::Log::debug() << "RecipeBase::ensureSetup running setup for recipe " << name()
+        << std::endl;
+      isSetup_ = setup(afieldset);
+      setupGeometry_ = std::move(geometry);
+      if (!isSetup_) return SetupLock();
+    }
+  }
+  ++executions_;
+  return SetupLock(this);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+RecipeBase::SetupLock::~SetupLock() {
+  if (recipe_ == nullptr) return;
+  std::lock_guard<std::mutex> lock(recipe_->setupMutex_);
+  if (--recipe_->executions_ == 0) recipe_->setupIdle_.notify_all();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void RecipeBase::invalidateSetup() {
+  std::lock_guard<std::mutex> lock(setupMutex_);
+  isSetup_ = false;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+std::unique_ptr<RecipeContext> RecipeBase::makeContext(const atlas::FieldSet &) const {
+  return std::make_unique<RecipeContext>();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+bool RecipeBase::executeBatch(const std::vector<atlas::FieldSet *> & members,
+                              const ColumnSelection & columns) {
+  bool success = true;
+  for (atlas::FieldSet * member : members) {
+    success = execute(*member, columns) && success;
+  }
+  return success;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+atlas::FunctionSpace RecipeBase::productFunctionSpace(const atlas::FieldSet & afieldset) const {
+  return afieldset.field(ingredients().front()).functionspace();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+atlas::idx_t RecipeBase::productLevels(const atlas::FieldSet & afieldset) const {
+  return afieldset.field(ingredients().front()).levels();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+atlas::array::DataType RecipeBase::productDataType(const atlas::FieldSet & afieldset) const {
+  return afieldset.field(ingredients().front()).datatype();
+}
+
+// ------------------------------------------------------------------------------------------------
+
 void RecipeBase::print(std::ostream & os) const {
   os << name();
 }
@@ -8,8 +8,10 @@
 #ifndef SRC_VADER_RECIPEBASE_H_
 #define SRC_VADER_RECIPEBASE_H_
 
+#include <condition_variable>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -22,6 +24,7 @@
 #include "oops/util/parameters/RequiredParameter.h"
 #include "oops/util/parameters/RequiredPolymorphicParameter.h"
 #include "oops/util/Printable.h"
+#include "vader/ColumnSelection.h"
 
 namespace vader {
 
@@ -37,6 +40,29 @@ class RecipeParametersBase : public oops::Parameters {
      this};
 };
 
+// ------------------------------------------------------------------------------------------------
+/// Estimated cost of a recipe per point (column and level) of its product, used by
+/// the planner to choose between the recipes that can produce a variable
+struct RecipeCost {
+  double flops;     ///< floating-point operations per point
+  double bytes;     ///< bytes read and written per point
+  bool columnScan;  ///< levels are computed one after the other (e.g. a vertical
+                    ///< integral), so the loop over levels cannot be vectorised
+
+/// Cost in units of the time needed to move one byte, for a machine doing 8 flops
+/// per byte moved with vectors of 4 doubles (flops of column scans are not vectorised)
+  double weight() const;
+};
+
+// ------------------------------------------------------------------------------------------------
+/// Base class for the values a recipe derives from the FieldSet it executes on (for
+/// instance from the units of an ingredient). Recipes make a context for every
+/// execution rather than storing such values in themselves.
+class RecipeContext {
+ public:
+  virtual ~RecipeContext() {}
+};
+
 // ------------------------------------------------------------------------------------------------
 /*! \brief RecipeBase class defines interface for individual variable
            transformations.
@@ -44,6 +70,11 @@ class RecipeParametersBase : public oops::Parameters {
  *  \details This pure virtual class provides the template for all concrete
  *           classes that calculate a variable using other variables
  *           (ingredients) as input.
+ *
+ *           Recipes are shared by all the concurrent changeVar calls of a Vader, so
+ *           execution must not modify the recipe: anything derived from the FieldSet
+ *           is held in a RecipeContext made for the execution. Only setup modifies
+ *           the recipe, and Vader never executes a recipe while it is being set up.
  */
 
 class RecipeBase : public util::Printable,
@@ -58,17 +89,122 @@ class RecipeBase : public util::Printable,
 /// Ingredients (list of variables required to setup and execute recipe)
   virtual std::vector<std::string> ingredients() const = 0;
 
+/// Estimated cost of executing the recipe. By default, the recipe is taken to be
+/// pointwise, doing one flop per point and reading every ingredient once in double
+/// precision.
+  virtual RecipeCost cost() const;
+
+/// Flag indicating whether the recipe can be used at all, whatever ingredients are
+/// available (a recipe lacking parameters it needs is not viable). Vader only plans
+/// viable recipes.
+  virtual bool isViable() const { return true; }
+
 /// Flag indicating whether the recipe requires setup.
   virtual bool requiresSetup() { return false; }
 /// setup must return true on success, false on failure
   virtual bool setup(atlas::FieldSet &) { return true; }
+/// Held while the recipe executes, so that another thread cannot set the recipe up
+/// again (for another geometry) meanwhile. Any number of executions can hold one.
+  class SetupLock {
+   public:
+    SetupLock() : recipe_(nullptr) {}
+    explicit SetupLock(RecipeBase * recipe) : recipe_(recipe) {}
+    SetupLock(SetupLock && other) noexcept : recipe_(other.recipe_) { other.recipe_ = nullptr; }
+    SetupLock & operator=(SetupLock &&) = delete;
+    ~SetupLock();
+    /// False if setup failed
+    bool owns_lock() const { return recipe_ != nullptr; }
+
+   private:
+    RecipeBase * recipe_;
+  };
+/// Runs setup if the recipe requires it and has not been set up yet for ingredients
+/// with the geometry of those in the FieldSet (function space, number of points,
+/// number of levels and data type). Whatever setup prepares is kept by the recipe
+/// and reused for later executions until the geometry changes or invalidateSetup is
+/// called. The returned lock must be held while the recipe executes, so that
+/// another thread cannot set the recipe up again for another geometry meanwhile; it
+/// does not own the mutex if setup fails.
+  SetupLock ensureSetup(atlas::FieldSet &);
+/// Forces setup to run again before the next execution
+  void invalidateSetup();
+
+/// Makes the context of an execution on the FieldSet, or returns nullptr if the
+/// recipe cannot execute on it (a fused stage is then executed recipe by recipe, with
+/// execute). By default a recipe needs no context and an empty one is returned.
+  virtual std::unique_ptr<RecipeContext> makeContext(const atlas::FieldSet &) const;
 
 /// Execute method performs the variable change
 /// execute must return true on success, false on failure
   virtual bool execute(atlas::FieldSet &) = 0;
+/// Performs the variable change for the selected columns only. Values of the product
+/// in other columns may be left untouched. Recipes that can restrict their work to
+/// some columns override this; by default every column is computed.
+  virtual bool execute(atlas::FieldSet & afieldset, const ColumnSelection &) {
+    return execute(afieldset);
+  }
+/// Executes the recipe for the selected columns of every member of a batch of
+/// FieldSets with the same layout. Vader calls ensureSetup on the first member
+/// beforehand: setup is where constant inputs should be loaded. By default execute
+/// is called for each member in turn; recipes whose execute can run concurrently for
+/// different FieldSets can override this to process the members in parallel.
+  virtual bool executeBatch(const std::vector<atlas::FieldSet *> &, const ColumnSelection &);
+
+/// Flag indicating whether the recipe provides a column kernel. A recipe can
+/// provide one when each column (horizontal point) of its product only depends on
+/// the same column of its ingredients. Vader fuses consecutive recipes of a plan
+/// that have column kernels, and evaluates them column by column in a single sweep.
+  virtual bool hasColumnKernel() const { return false; }
+/// Column kernel. ingredientColumns[i] points to the values of the i-th ingredient
+/// (in the order of ingredients()) in one column and ingredientLevels[i] is the
+/// number of levels of that ingredient. The kernel must write the productLevels
+/// values of productColumn. It is called after setup, concurrently for different
+/// columns, with the context made by makeContext for the FieldSet of the column.
+  virtual void executeColumn(const RecipeContext & context,
+                             const double * const * ingredientColumns,
+                             const atlas::idx_t * ingredientLevels,
+                             double * productColumn,
+                             const atlas::idx_t productLevels) const {}
+/// Flag indicating whether the recipe provides a column kernel for single precision
+/// fields. Without one, Vader converts the columns of single precision fields to
+/// double precision, evaluates them with the double precision kernel and converts the
+/// product back.
+  virtual bool hasFloatColumnKernel() const { return false; }
+/// Column kernel for single precision fields, used if hasFloatColumnKernel is true.
+  virtual void executeColumn(const RecipeContext & context,
+                             const float * const * ingredientColumns,
+                             const atlas::idx_t * ingredientLevels,
+                             float * productColumn,
+                             const atlas::idx_t productLevels) const {}
+
+/// Function space and number of levels of the product, used when Vader allocates
+/// the product itself as an intermediate (scratch) field. The FieldSet holds the
+/// ingredients. By default the product has the shape and the data type (precision)
+/// of the first ingredient.
+  virtual atlas::FunctionSpace productFunctionSpace(const atlas::FieldSet &) const;
+  virtual atlas::idx_t productLevels(const atlas::FieldSet &) const;
+  virtual atlas::array::DataType productDataType(const atlas::FieldSet &) const;
 
  private:
   virtual void print(std::ostream &) const;
+
+  /// Geometry of an ingredient field when setup last ran
+  struct IngredientGeometry {
+      const void * functionspace;
+      atlas::idx_t points;
+      atlas::idx_t levels;
+      int datatype;
+      bool operator==(const IngredientGeometry & other) const {
+          return functionspace == other.functionspace && points == other.points &&
+                 levels == other.levels && datatype == other.datatype;
+      }
+  };
+
+  std::mutex setupMutex_;
+  std::condition_variable setupIdle_;
+  std::size_t executions_ = 0;
+  bool isSetup_ = false;
+  std::vector<IngredientGeometry> setupGeometry_;
 };
 
 // ------------------------------------------------------------------------------------------------
@@ -0,0 +1,57 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <string>
+
+#include "atlas/option.h"
+#include "eckit/exception/Exceptions.h"
+#include "vader/ScratchArena.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+atlas::Field ScratchArena::acquire(const std::string & name,
+                                   const atlas::FunctionSpace & functionSpace,
+                                   atlas::idx_t levels,
+                                   atlas::array::DataType datatype) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = free_.begin(); it != free_.end(); ++it) {
+            if (it->functionspace().get() == functionSpace.get() && it->levels() == levels &&
+                it->datatype() == datatype) {
+                atlas::Field field = *it;
+                free_.erase(it);
+                field.rename(name);
+                return field;
+            }
+        }
+    }
+    const auto config = atlas::option::name(name) | atlas::option::levels(levels);
+    if (datatype == atlas::array::DataType::real32()) {
+        return functionSpace.createField<float>(config);
+    }
+    ASSERT(datatype == atlas::array::DataType::real64());
+    return functionSpace.createField<double>(config);
+}
+// ------------------------------------------------------------------------------------------------
+void ScratchArena::release(const atlas::Field & field) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.size() == maxPooled_) free_.erase(free_.begin());
+    free_.push_back(field);
+}
+// ------------------------------------------------------------------------------------------------
+std::size_t ScratchArena::pooled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_.size();
+}
+// ------------------------------------------------------------------------------------------------
+void ScratchArena::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.clear();
+}
+
+}  // namespace vader
@@ -0,0 +1,59 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_SCRATCHARENA_H_
+#define SRC_VADER_SCRATCHARENA_H_
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "atlas/array/DataType.h"
+#include "atlas/field/Field.h"
+#include "atlas/functionspace.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief ScratchArena class pools the fields Vader allocates for intermediates
+ *
+ *  \details Variables that a plan only needs as ingredients of other recipes, and
+ *           that are not allocated in the caller's FieldSet, are made by Vader in
+ *           scratch fields. A scratch field is acquired from the arena just before
+ *           the recipe producing it runs, and released back to the arena once its
+ *           last consumer has run, so that a later intermediate (of the same or of
+ *           a later changeVar) with the same function space, number of levels and
+ *           data type reuses the memory instead of allocating again.
+ *
+ *           At most maxPooled released fields are kept; the arena is thread safe.
+ */
+class ScratchArena : private boost::noncopyable {
+ public:
+    explicit ScratchArena(std::size_t maxPooled = 16) : maxPooled_(maxPooled) {}
+
+    /// Returns a field with the given name, function space, number of levels and
+    /// data type (real32 or real64). The values of the field are undefined.
+    atlas::Field acquire(const std::string &, const atlas::FunctionSpace &, atlas::idx_t,
+                         atlas::array::DataType = atlas::array::DataType::real64());
+    /// Returns a field previously acquired to the pool
+    void release(const atlas::Field &);
+    /// Number of released fields currently held by the pool
+    std::size_t pooled() const;
+    void clear();
+
+ private:
+    const std::size_t maxPooled_;
+    mutable std::mutex mutex_;
+    std::vector<atlas::Field> free_;
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_SCRATCHARENA_H_
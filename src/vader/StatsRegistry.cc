@@ -0,0 +1,134 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <algorithm>
+#include <map>
+#include <ostream>
+#include <string>
+
+#include "atlas/field/Field.h"
+#include "vader/StatsRegistry.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+StatsRegistry & StatsRegistry::global() {
+    static StatsRegistry registry;
+    return registry;
+}
+// ------------------------------------------------------------------------------------------------
+void StatsRegistry::record(const std::string & name, double wallTime, std::size_t points,
+                           std::size_t bytesRead, std::size_t bytesWritten) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    KernelStats & stats = stats_[name];
+    ++stats.calls;
+    stats.wallTime += wallTime;
+    stats.points += points;
+    stats.bytesRead += bytesRead;
+    stats.bytesWritten += bytesWritten;
+}
+// ------------------------------------------------------------------------------------------------
+KernelStats StatsRegistry::get(const std::string & name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = stats_.find(name);
+    return it == stats_.end() ? KernelStats() : it->second;
+}
+// ------------------------------------------------------------------------------------------------
+std::map<std::string, KernelStats> StatsRegistry::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+// ------------------------------------------------------------------------------------------------
+bool StatsRegistry::empty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_.empty();
+}
+// ------------------------------------------------------------------------------------------------
+void StatsRegistry::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.clear();
+}
+// ------------------------------------------------------------------------------------------------
+void StatsRegistry::writeJSON(std::ostream & os) const {
+    const std::map<std::string, KernelStats> stats = snapshot();
+    os << "{";
+    const char * separator = "";
+    for (const auto & entry : stats) {
+        const KernelStats & kernel = entry.second;
+        const double seconds = std::max(kernel.wallTime, 1.0e-12);
+        os << separator << "\"" << entry.first << "\": {"
+           << "\"calls\": " << kernel.calls
+           << ", \"wall_time_s\": " << kernel.wallTime
+           << ", \"points\": " << kernel.points
+           << ", \"bytes_read\": " << kernel.bytesRead
+           << ", \"bytes_written\": " << kernel.bytesWritten
+           << ", \"points_per_s\": " << kernel.points / seconds
+           << ", \"gbytes_per_s\": " << (kernel.bytesRead + kernel.bytesWritten) * 1.0e-9 / seconds
+           << "}";
+        separator = ", ";
+    }
+    os << "}";
+}
+// ------------------------------------------------------------------------------------------------
+void StatsRegistry::print(std::ostream & os) const {
+    writeJSON(os);
+}
+// ------------------------------------------------------------------------------------------------
+ScopedKernelTimer::ScopedKernelTimer(const std::string & name, StatsRegistry & registry)
+    : name_(name), registry_(registry), columns_(nullptr),
+      start_(std::chrono::steady_clock::now()), points_(0), bytesRead_(0), bytesWritten_(0) {}
+// ------------------------------------------------------------------------------------------------
+ScopedKernelTimer::ScopedKernelTimer(const std::string & name, const ColumnSelection & columns,
+                                     StatsRegistry & registry)
+    : name_(name), registry_(registry), columns_(&columns),
+      start_(std::chrono::steady_clock::now()), points_(0), bytesRead_(0), bytesWritten_(0) {}
+// ------------------------------------------------------------------------------------------------
+ScopedKernelTimer::~ScopedKernelTimer() {
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+    registry_.record(name_, elapsed.count(), points_, bytesRead_, bytesWritten_);
+}
+// ------------------------------------------------------------------------------------------------
+ScopedKernelTimer & ScopedKernelTimer::reads(const atlas::Field & field) {
+    bytesRead_ += selected(field, field.bytes());
+    return *this;
+}
+// ------------------------------------------------------------------------------------------------
+ScopedKernelTimer & ScopedKernelTimer::writes(const atlas::Field & field) {
+    bytesWritten_ += selected(field, field.bytes());
+    points_ = std::max(points_, selected(field, field.size()));
+    return *this;
+}
+// ------------------------------------------------------------------------------------------------
+std::size_t ScopedKernelTimer::selected(const atlas::Field & field, std::size_t amount) const {
+    const atlas::idx_t ncolumns = field.shape(0);
+    if (columns_ == nullptr || columns_->all() || ncolumns == 0) return amount;
+    return amount / static_cast<std::size_t>(ncolumns) *
+           static_cast<std::size_t>(columns_->size(ncolumns));
+}
+// ------------------------------------------------------------------------------------------------
+ScopedKernelTimer & ScopedKernelTimer::points(std::size_t points) {
+    points_ = points;
+    return *this;
+}
+// ------------------------------------------------------------------------------------------------
+ScopedKernelTimer & ScopedKernelTimer::reads(const atlas::FieldSet & fields,
+                                             std::initializer_list<const char *> names) {
+    for (const char * name : names) {
+        if (fields.has(name)) reads(fields.field(name));
+    }
+    return *this;
+}
+// ------------------------------------------------------------------------------------------------
+ScopedKernelTimer & ScopedKernelTimer::writes(const atlas::FieldSet & fields,
+                                              std::initializer_list<const char *> names) {
+    for (const char * name : names) {
+        if (fields.has(name)) writes(fields.field(name));
+    }
+    return *this;
+}
+
+}  // namespace vader
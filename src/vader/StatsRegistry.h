@@ -0,0 +1,113 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_STATSREGISTRY_H_
+#define SRC_VADER_STATSREGISTRY_H_
+
+#include <chrono>
+#include <cstddef>
+#include <initializer_list>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+
+#include "atlas/field/FieldSet.h"
+#include "oops/util/Printable.h"
+#include "vader/ColumnSelection.h"
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+/// Accumulated statistics of one kernel (a recipe, or a function of the mo library).
+/// The bytes read and written are estimated from the shapes of the fields the kernel
+/// uses, assuming each value is read or written once.
+struct KernelStats {
+    std::size_t calls = 0;
+    double wallTime = 0.0;  ///< seconds
+    std::size_t points = 0;
+    std::size_t bytesRead = 0;
+    std::size_t bytesWritten = 0;
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief StatsRegistry class accumulates kernel statistics
+ *
+ *  \details Each Vader object has a registry for the recipes it executes, and the
+ *           process-wide registry returned by global() collects the statistics of
+ *           the mo functions. Statistics are recorded with a ScopedKernelTimer.
+ *           All methods are thread safe.
+ */
+class StatsRegistry : public util::Printable,
+                      private boost::noncopyable {
+ public:
+    static StatsRegistry & global();
+
+    void record(const std::string & name, double wallTime, std::size_t points,
+                std::size_t bytesRead, std::size_t bytesWritten);
+    /// Statistics for one kernel (all zero if the kernel has not been recorded)
+    KernelStats get(const std::string & name) const;
+    /// Copy of the statistics of all the kernels, by kernel name
+    std::map<std::string, KernelStats> snapshot() const;
+    bool empty() const;
+    void reset();
+    /// Writes the statistics as a JSON object, with one member per kernel
+    void writeJSON(std::ostream &) const;
+
+ private:
+    void print(std::ostream &) const override;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, KernelStats> stats_;
+};
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief ScopedKernelTimer records one call of a kernel in a StatsRegistry
+ *
+ *  \details The wall time is measured from construction to destruction. The fields
+ *           the kernel reads and writes are declared with reads() and writes(): the
+ *           bytes of every field are added to the bytes read or written, and by
+ *           default the number of points is the size of the largest field written.
+ *           A kernel that only computes some columns passes its ColumnSelection, which
+ *           must outlive the timer: only the selected columns of each field are then
+ *           counted.
+ */
+class ScopedKernelTimer : private boost::noncopyable {
+ public:
+    explicit ScopedKernelTimer(const std::string & name,
+                               StatsRegistry & registry = StatsRegistry::global());
+    ScopedKernelTimer(const std::string & name, const ColumnSelection & columns,
+                      StatsRegistry & registry = StatsRegistry::global());
+    ~ScopedKernelTimer();
+
+    ScopedKernelTimer & reads(const atlas::Field &);
+    ScopedKernelTimer & writes(const atlas::Field &);
+    /// Declares the fields of the FieldSet with the given names; names of fields that
+    /// are not in the FieldSet are ignored
+    ScopedKernelTimer & reads(const atlas::FieldSet &, std::initializer_list<const char *>);
+    ScopedKernelTimer & writes(const atlas::FieldSet &, std::initializer_list<const char *>);
+    /// Sets the number of points, when it is not the size of the largest field written
+    ScopedKernelTimer & points(std::size_t);
+
+ private:
+    /// Part of the amount (bytes or points) for the whole field in the selected columns
+    std::size_t selected(const atlas::Field &, std::size_t amount) const;
+
+    const std::string name_;
+    StatsRegistry & registry_;
+    const ColumnSelection * columns_;
+    const std::chrono::steady_clock::time_point start_;
+    std::size_t points_;
+    std::size_t bytesRead_;
+    std::size_t bytesWritten_;
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_STATSREGISTRY_H_
@@ -8,6 +8,7 @@
 #ifndef SRC_VADER_VADERPARAMETERS_H_
 #define SRC_VADER_VADERPARAMETERS_H_
 
+#include <string>
 #include <vector>
 
 #include "oops/util/parameters/OptionalParameter.h"
@@ -32,6 +33,32 @@ class VaderParameters : public oops::Parameters {
      "recipe parameters",
      "Parameters to configure individual recipe functionality",
      this};
+
+  /// 'concurrent recipes' allows recipes of a plan that do not depend on each
+  /// other to be executed at the same time (when Vader is built with OpenMP and nested
+  /// parallelism is enabled, e.g. with OMP_MAX_ACTIVE_LEVELS=2).
+  oops::Parameter<bool> concurrentRecipes{
+     "concurrent recipes",
+     "Execute independent recipes of a plan concurrently",
+     true,
+     this};
+
+  /// 'fuse column kernels' evaluates consecutive recipes of a plan that provide
+  /// column kernels in a single sweep over the columns of the fieldset.
+  oops::Parameter<bool> fuseColumnKernels{
+     "fuse column kernels",
+     "Evaluate consecutive recipes with column kernels in a single sweep",
+     true,
+     this};
+
+  /// 'stats file' names a file the recipe and kernel statistics are written to
+  /// (as one JSON object per line, one line per Vader) when Vader is destroyed. With
+  /// several MPI tasks each task writes its own file, named with the rank appended
+  /// ("stats.json.3"). They are always written to oops::Log::stats().
+  oops::OptionalParameter<std::string> statsFile{
+     "stats file",
+     "File to write the recipe and kernel statistics to as JSON",
+     this};
 };
 
 }  // namespace vader
@@ -0,0 +1,48 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#include <string>
+#include <vector>
+
+#include "vader/vadervariables.h"
+#include "vader/VariableTable.h"
+
+namespace vader {
+
+const VariableTable::Id VariableTable::npos = static_cast<VariableTable::Id>(-1);
+
+// ------------------------------------------------------------------------------------------------
+VariableTable::VariableTable() {
+    for (const char * variableName : VV_ALL) {
+        intern(variableName);
+    }
+}
+// ------------------------------------------------------------------------------------------------
+VariableTable::Id VariableTable::intern(const std::string & variableName) {
+    auto it = ids_.find(variableName);
+    if (it != ids_.end()) return it->second;
+    const Id id = names_.size();
+    names_.push_back(variableName);
+    ids_.emplace(variableName, id);
+    return id;
+}
+// ------------------------------------------------------------------------------------------------
+VariableTable::Id VariableTable::find(const std::string & variableName) const {
+    auto it = ids_.find(variableName);
+    return it == ids_.end() ? npos : it->second;
+}
+// ------------------------------------------------------------------------------------------------
+VariableTable::Set VariableTable::set(const std::vector<std::string> & variableNames) const {
+    Set variables(names_.size());
+    for (const auto & variableName : variableNames) {
+        const Id id = find(variableName);
+        if (id != npos) variables.set(id);
+    }
+    return variables;
+}
+
+}  // namespace vader
@@ -0,0 +1,58 @@
+/*
+ * (C) Copyright 2022 UCAR
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ */
+
+#ifndef SRC_VADER_VARIABLETABLE_H_
+#define SRC_VADER_VARIABLETABLE_H_
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/dynamic_bitset.hpp>
+
+namespace vader {
+
+// ------------------------------------------------------------------------------------------------
+/*! \brief VariableTable class interns variable names as integer ids
+ *
+ *  \details Vader plans on integer variable ids rather than on variable names, so
+ *           that checking whether an ingredient is available is a bit test rather
+ *           than a search through a list of strings. The table is seeded with the
+ *           VV_* names in vadervariables.h, and any other variable named in the
+ *           cookbook is added when the cookbook is created.
+ *
+ *           Sets of variables (e.g. the fields allocated in a FieldSet) are held as
+ *           bitsets with one bit per id in the table.
+ */
+class VariableTable {
+ public:
+    typedef std::size_t Id;
+    typedef boost::dynamic_bitset<> Set;
+    static const Id npos;
+
+    VariableTable();
+
+    /// Returns the id of the variable, adding the variable to the table if needed
+    Id intern(const std::string &);
+    /// Returns the id of the variable, or npos if the variable is not in the table
+    Id find(const std::string &) const;
+    const std::string & name(const Id id) const {return names_[id];}
+    std::size_t size() const {return names_.size();}
+
+    /// Returns a set with the bits of the listed variables set. Variables not in the
+    /// table are ignored.
+    Set set(const std::vector<std::string> &) const;
+
+ private:
+    std::unordered_map<std::string, Id> ids_;
+    std::vector<std::string> names_;
+};
+
+}  // namespace vader
+
+#endif  // SRC_VADER_VARIABLETABLE_H_
@@ -6,7 +6,9 @@
  */
 
 #include <math.h>
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "atlas/array.h"
@@ -25,14 +27,38 @@ const std::vector<std::string> PressureToDelP::Ingredients = {VV_PS};
 // Register the maker
 static RecipeMaker<PressureToDelP> makerPressureToDelP_(PressureToDelP::Name);
 
+namespace {
+/// Differences between consecutive interfaces of hybrid coefficients, or nothing if
+/// the coefficients do not describe at least one level
+std::vector<double> interfaceDifferences(const std::vector<double> & coefficients,
+                                         const std::size_t ninterfaces) {
+    std::vector<double> differences;
+    if (coefficients.size() != ninterfaces || ninterfaces < 2) return differences;
+    differences.resize(ninterfaces - 1);
+    for (std::size_t k = 0; k + 1 < ninterfaces; ++k) {
+        differences[k] = coefficients[k + 1] - coefficients[k];
+    }
+    return differences;
+}
+}  // namespace
+
 PressureToDelP::PressureToDelP()
 {
     oops::Log::trace() << "PressureToDelP::PressureToDelP()" << std::endl;
 }
 
-PressureToDelP::PressureToDelP(const PressureToDelPParameters &params)
+PressureToDelP::PressureToDelP(const PressureToDelPParameters &params) :
+    dak_{interfaceDifferences(params.ak.value(), params.ak.value().size())},
+    dbk_{interfaceDifferences(params.bk.value(), params.ak.value().size())}
 {
     oops::Log::trace() << "PressureToDelP::PressureToDelP(params)" << std::endl;
+    if (!params.ak.value().empty() && (dak_.empty() || dbk_.empty())) {
+        oops::Log::error() << "PressureToDelP: ak and bk must both have nlevels + 1 values "
+            "(got " << params.ak.value().size() << " and " << params.bk.value().size() <<
+            "); the recipe will not be used." << std::endl;
+    }
+    oops::Log::debug() << "PressureToDelP params number of levels: " << dak_.size() <<
+        std::endl;
 }
 
 std::string PressureToDelP::name() const
@@ -45,14 +71,124 @@ std::vector<std::string> PressureToDelP::ingredients() const
     return PressureToDelP::Ingredients;
 }
 
+RecipeCost PressureToDelP::cost() const
+{
+    // One multiply-add per point; only the thickness is written per point, the surface
+    // pressure is read once per column
+    return RecipeCost{2.0, sizeof(double), false};
+}
+
+bool PressureToDelP::isViable() const
+{
+    return !dak_.empty() && dak_.size() == dbk_.size();
+}
+
+atlas::idx_t PressureToDelP::productLevels(const atlas::FieldSet &) const
+{
+    return static_cast<atlas::idx_t>(dak_.size());
+}
+
+std::unique_ptr<RecipeContext> PressureToDelP::makeContext(
+    const atlas::FieldSet & afieldset) const
+{
+    // The column kernel writes one value per level of ak and bk, so it only runs on a
+    // product with that many levels; execute reports the mismatch otherwise
+    if (!isViable() || afieldset.field(VV_DELP).levels() != productLevels(afieldset)) {
+        return nullptr;
+    }
+    return RecipeBase::makeContext(afieldset);
+}
+
 bool PressureToDelP::execute(atlas::FieldSet & afieldset)
 {
-    bool delp_filled = false;
+    return execute(afieldset, ColumnSelection());
+}
 
+bool PressureToDelP::execute(atlas::FieldSet & afieldset, const ColumnSelection & columns)
+{
     oops::Log::trace() << "entering ps_to_delp execute function" << std::endl;
-    // TODO(Someone who knows this algorithm): Implement conversion logic
+
+    if (!isViable()) {
+        oops::Log::error() << "PressureToDelP::execute failed because ak and bk are not set." <<
+            std::endl;
+        return false;
+    }
+    const atlas::Field delp = afieldset.field(VV_DELP);
+    if (delp.levels() != productLevels(afieldset)) {
+        oops::Log::error() << "PressureToDelP::execute failed because " << VV_DELP << " has " <<
+            delp.levels() << " levels and ak and bk define " << productLevels(afieldset) <<
+            "." << std::endl;
+        return false;
+    }
+
+    if (delp.datatype() == atlas::array::DataType::real32()) {
+        computeThickness<float>(afieldset, columns);
+    } else {
+        computeThickness<double>(afieldset, columns);
+    }
+
     oops::Log::trace() << "leaving ps_to_delp execute function" << std::endl;
-    return delp_filled;
+    return true;
+}
+
+bool PressureToDelP::hasColumnKernel() const
+{
+    return true;
+}
+
+bool PressureToDelP::hasFloatColumnKernel() const
+{
+    return true;
+}
+
+void PressureToDelP::executeColumn(const RecipeContext &,
+                                   const double * const * ingredientColumns,
+                                   const atlas::idx_t *,
+                                   double * delp,
+                                   const atlas::idx_t) const
+{
+    computeColumn(ingredientColumns[0][0], delp);
+}
+
+void PressureToDelP::executeColumn(const RecipeContext &,
+                                   const float * const * ingredientColumns,
+                                   const atlas::idx_t *,
+                                   float * delp,
+                                   const atlas::idx_t) const
+{
+    computeColumn(ingredientColumns[0][0], delp);
+}
+
+template <typename T>
+void PressureToDelP::computeThickness(atlas::FieldSet & afieldset,
+                                      const ColumnSelection & columns) const
+{
+    const auto surface_pressure_view =
+        atlas::array::make_view<const T, 2>(afieldset.field(VV_PS));
+    auto delp_view = atlas::array::make_view<T, 2>(afieldset.field(VV_DELP));
+
+    const atlas::idx_t ncolumns = columns.size(surface_pressure_view.shape(0));
+    const atlas::idx_t * selected = columns.all() ? nullptr : columns.columns().data();
+
+#pragma omp parallel for schedule(static)
+    for (atlas::idx_t k = 0; k < ncolumns; ++k) {
+        const atlas::idx_t jnode = selected ? selected[k] : k;
+        computeColumn(surface_pressure_view(jnode, 0), &delp_view(jnode, 0));
+    }
+}
+
+template <typename T>
+void PressureToDelP::computeColumn(const T surface_pressure, T * delp) const
+{
+    // delp(k) = (ak(k+1) + bk(k+1) ps) - (ak(k) + bk(k) ps), with the differences of
+    // the coefficients computed once in the constructor
+    const double * dak = dak_.data();
+    const double * dbk = dbk_.data();
+    const atlas::idx_t nlevels = static_cast<atlas::idx_t>(dak_.size());
+#pragma omp simd
+    for (atlas::idx_t level = 0; level < nlevels; ++level) {
+        delp[level] = dak[level] + dbk[level] * surface_pressure;
+    }
 }
 
 }  // namespace vader
@@ -8,10 +8,13 @@
 #ifndef SRC_VADER_RECIPES_PRESSURETODELP_H_
 #define SRC_VADER_RECIPES_PRESSURETODELP_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "atlas/field/FieldSet.h"
+#include "oops/util/parameters/Parameter.h"
+#include "oops/util/parameters/RequiredParameter.h"
 #include "vader/RecipeBase.h"
 
 namespace vader
@@ -24,12 +27,24 @@ class PressureToDelPParameters : public RecipeParametersBase {
   oops::RequiredParameter<std::string> name{
      "recipe name",
      this};
-     // No parameters for this recipe currently
+  oops::Parameter<std::vector<double>> ak{"ak",
+     "hybrid coefficients ak (Pa) of the level interfaces", {}, this};
+  oops::Parameter<std::vector<double>> bk{"bk",
+     "hybrid coefficients bk of the level interfaces", {}, this};
 };
 
 // ------------------------------------------------------------------------------------------------
-/// Recipe base class
-
+/*! \brief PressureToDelP class defines a recipe for pressure thickness
+ *
+ *  \details This instantiation of RecipeBase produces the pressure thickness of the
+ *           levels (air_pressure_thickness) from the surface pressure, for hybrid
+ *           sigma-pressure levels. The pressure of the level interfaces is
+ *           ak + bk * ps, and the thickness of level k is the pressure of interface
+ *           k + 1 minus that of interface k. The coefficients ak and bk of the
+ *           nlevels + 1 interfaces must be given in the parameters, in the order of
+ *           the levels of air_pressure_thickness; the recipe is not viable without
+ *           them. ak and the surface pressure must be in the same units.
+ */
 class PressureToDelP : public RecipeBase
 {
  public:
@@ -41,11 +56,31 @@ class PressureToDelP : public RecipeBase
     PressureToDelP();
     explicit PressureToDelP(const Parameters_ &);
 
+    // Recipe base class overrides
     std::string name() const override;
     std::vector<std::string> ingredients() const override;
+    RecipeCost cost() const override;
+    bool isViable() const override;
     bool execute(atlas::FieldSet &) override;
+    bool execute(atlas::FieldSet &, const ColumnSelection &) override;
+    bool hasColumnKernel() const override;
+    bool hasFloatColumnKernel() const override;
+    void executeColumn(const RecipeContext &, const double * const *, const atlas::idx_t *,
+                       double *, const atlas::idx_t) const override;
+    void executeColumn(const RecipeContext &, const float * const *, const atlas::idx_t *,
+                       float *, const atlas::idx_t) const override;
+    atlas::idx_t productLevels(const atlas::FieldSet &) const override;
+    std::unique_ptr<RecipeContext> makeContext(const atlas::FieldSet &) const override;
 
  private:
+    template <typename T>
+    void computeThickness(atlas::FieldSet &, const ColumnSelection &) const;
+    template <typename T>
+    void computeColumn(const T, T *) const;
+
+    // Differences of ak and bk between consecutive interfaces
+    const std::vector<double> dak_;
+    const std::vector<double> dbk_;
 };
 }  // namespace vader
 
@@ -6,7 +6,9 @@
  */
 
 #include <math.h>
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "atlas/array.h"
@@ -31,6 +33,14 @@ const double default_hPa_p0 = 1000.0;
 // Register the maker
 static RecipeMaker<TempToPTemp> makerTempToPTemp_(TempToPTemp::Name);
 
+namespace {
+/// p0 used by one execution
+struct TempToPTempContext : public RecipeContext {
+    explicit TempToPTempContext(double p0) : p0(p0) {}
+    const double p0;
+};
+}  // namespace
+
 TempToPTemp::TempToPTemp() :
     p0_{p0_not_in_params},
     kappa_{default_kappa}
@@ -59,53 +69,67 @@ std::vector<std::string> TempToPTemp::ingredients() const
     return TempToPTemp::Ingredients;
 }
 
-bool TempToPTemp::execute(atlas::FieldSet & afieldset)
+RecipeCost TempToPTemp::cost() const
 {
-    bool potential_temperature_filled = false;
+    // Temperature is read and potential temperature written once per point, the
+    // surface pressure only once per column
+    return RecipeCost{2.0, 2.0 * sizeof(double), false};
+}
 
-    oops::Log::trace() << "entering TempToPTemp::execute function"
-        << std::endl;
+std::unique_ptr<RecipeContext> TempToPTemp::makeContext(const atlas::FieldSet & afieldset) const
+{
+    double p0;
+    if (!deduceP0(afieldset, p0)) return nullptr;
+    return std::make_unique<TempToPTempContext>(p0);
+}
 
-    atlas::Field temperature = afieldset.field(VV_TS);
-    atlas::Field surface_pressure = afieldset.field(VV_PS);
-    atlas::Field potential_temperature = afieldset.field(VV_PT);
-    std::string t_units, ps_units;
+bool TempToPTemp::deduceP0(const atlas::FieldSet & afieldset, double & p0) const
+{
+    std::string ps_units;
 
-    temperature.metadata().get("units", t_units);
-    surface_pressure.metadata().get("units", ps_units);
+    afieldset.field(VV_PS).metadata().get("units", ps_units);
+    p0 = p0_;
     if (p0_ == p0_not_in_params)
     {
         oops::Log::debug() << "TempToPTemp: p0 not in parameters. Deducing "
             "value from pressure units." << std::endl;
         if (ps_units == "Pa")
         {
-            p0_ = default_Pa_p0;
+            p0 = default_Pa_p0;
         } else if (ps_units == "hPa") {
-            p0_ = default_hPa_p0;
+            p0 = default_hPa_p0;
         } else {
             oops::Log::error() <<
               "TempToPTemp::execute failed because p0 could not be determined." << std::endl;
             return false;
         }
     }
+    return true;
+}
+
+bool TempToPTemp::execute(atlas::FieldSet & afieldset)
+{
+    bool potential_temperature_filled = false;
+
+    oops::Log::trace() << "entering TempToPTemp::execute function"
+        << std::endl;
+
+    atlas::Field temperature = afieldset.field(VV_TS);
+    atlas::Field surface_pressure = afieldset.field(VV_PS);
+    atlas::Field potential_temperature = afieldset.field(VV_PT);
 
-    oops::Log::debug() << "TempToPTemp::execute: p0 value: " << p0_ <<
+    double p0;
+    if (!deduceP0(afieldset, p0)) return false;
+
+    oops::Log::debug() << "TempToPTemp::execute: p0 value: " << p0 <<
         std::endl;
     oops::Log::debug() << "TempToPTemp::execute: kappa value: " << kappa_ <<
     std::endl;
 
-    auto temperature_view = atlas::array::make_view<double, 2>(temperature);
-    auto surface_pressure_view = atlas::array::make_view<double, 2>(surface_pressure);
-    auto potential_temperature_view = atlas::array::make_view<double, 2>(potential_temperature);
-
-    size_t grid_size = surface_pressure.size();
-
-    int nlevels = temperature.levels();
-    for (int level = 0; level < nlevels; ++level) {
-      for ( size_t jnode = 0; jnode < grid_size ; ++jnode ) {
-        potential_temperature_view(jnode, level) =
-            temperature_view(jnode, level) * pow(p0_ / surface_pressure_view(jnode, 0), kappa_);
-      }
+    if (temperature.datatype() == atlas::array::DataType::real32()) {
+        computePotentialTemperature<float>(afieldset, ColumnSelection(), p0);
+    } else {
+        computePotentialTemperature<double>(afieldset, ColumnSelection(), p0);
     }
 
     potential_temperature_filled = true;
@@ -115,4 +139,127 @@ bool TempToPTemp::execute(atlas::FieldSet & afieldset)
     return potential_temperature_filled;
 }
 
+bool TempToPTemp::execute(atlas::FieldSet & afieldset, const ColumnSelection & columns)
+{
+    if (columns.all()) return execute(afieldset);
+
+    oops::Log::trace() << "entering TempToPTemp::execute function for " << columns
+        << std::endl;
+
+    double p0;
+    if (!deduceP0(afieldset, p0)) return false;
+
+    if (afieldset.field(VV_TS).datatype() == atlas::array::DataType::real32()) {
+        computePotentialTemperature<float>(afieldset, columns, p0);
+    } else {
+        computePotentialTemperature<double>(afieldset, columns, p0);
+    }
+
+    oops::Log::trace() << "leaving TempToPTemp::execute function" << std::endl;
+
+    return true;
+}
+
+bool TempToPTemp::hasColumnKernel() const
+{
+    return true;
+}
+
+bool TempToPTemp::hasFloatColumnKernel() const
+{
+    return true;
+}
+
+void TempToPTemp::executeColumn(const RecipeContext & context,
+                                const double * const * ingredientColumns,
+                                const atlas::idx_t * ingredientLevels,
+                                double * potential_temperature,
+                                const atlas::idx_t nlevels) const
+{
+    computeColumn(ingredientColumns, potential_temperature, nlevels,
+                  static_cast<const TempToPTempContext &>(context).p0);
+}
+
+void TempToPTemp::executeColumn(const RecipeContext & context,
+                                const float * const * ingredientColumns,
+                                const atlas::idx_t * ingredientLevels,
+                                float * potential_temperature,
+                                const atlas::idx_t nlevels) const
+{
+    computeColumn(ingredientColumns, potential_temperature, nlevels,
+                  static_cast<const TempToPTempContext &>(context).p0);
+}
+
+template <typename T>
+void TempToPTemp::computePotentialTemperature(atlas::FieldSet & afieldset,
+                                              const ColumnSelection & columns,
+                                              const double p0) const
+{
+    const auto temperature_view = atlas::array::make_view<const T, 2>(afieldset.field(VV_TS));
+    const auto surface_pressure_view =
+        atlas::array::make_view<const T, 2>(afieldset.field(VV_PS));
+    auto potential_temperature_view = atlas::array::make_view<T, 2>(afieldset.field(VV_PT));
+
+    const atlas::idx_t nlevels = temperature_view.shape(1);
+    const atlas::idx_t ncolumns = columns.size(surface_pressure_view.shape(0));
+    const atlas::idx_t * selected = columns.all() ? nullptr : columns.columns().data();
+
+    // The factor (p0 / ps)^kappa only depends on the column. It is computed once per
+    // column, for a block of columns at a time so that the pow loop can be vectorized,
+    // and each column of the block is then scaled level by level with unit stride.
+    // Columns are addressed one at a time, so only the level stride has to be 1; other
+    // layouts are scaled through the views.
+    const bool unitStride = temperature_view.stride(1) == 1 &&
+                            potential_temperature_view.stride(1) == 1;
+    constexpr atlas::idx_t kBlockSize = 64;
+    const atlas::idx_t nblocks = (ncolumns + kBlockSize - 1) / kBlockSize;
+#pragma omp parallel for schedule(static)
+    for (atlas::idx_t jblock = 0; jblock < nblocks; ++jblock) {
+        const atlas::idx_t first = jblock * kBlockSize;
+        const atlas::idx_t count = std::min(kBlockSize, ncolumns - first);
+        atlas::idx_t jnodes[kBlockSize];
+        T factors[kBlockSize];
+        for (atlas::idx_t k = 0; k < count; ++k) {
+            jnodes[k] = selected ? selected[first + k] : first + k;
+        }
+#pragma omp simd
+        for (atlas::idx_t k = 0; k < count; ++k) {
+            factors[k] = pow(p0 / surface_pressure_view(jnodes[k], 0), kappa_);
+        }
+        if (!unitStride) {
+            for (atlas::idx_t k = 0; k < count; ++k) {
+                for (atlas::idx_t level = 0; level < nlevels; ++level) {
+                    potential_temperature_view(jnodes[k], level) =
+                        temperature_view(jnodes[k], level) * factors[k];
+                }
+            }
+            continue;
+        }
+        for (atlas::idx_t k = 0; k < count; ++k) {
+            const T * temperature = &temperature_view(jnodes[k], 0);
+            T * potential_temperature = &potential_temperature_view(jnodes[k], 0);
+            const T factor = factors[k];
+#pragma omp simd
+            for (atlas::idx_t level = 0; level < nlevels; ++level) {
+                potential_temperature[level] = temperature[level] * factor;
+            }
+        }
+    }
+}
+
+template <typename T>
+void TempToPTemp::computeColumn(const T * const * ingredientColumns,
+                                T * potential_temperature,
+                                const atlas::idx_t nlevels,
+                                const double p0) const
+{
+    // Ingredients are in the order of TempToPTemp::Ingredients
+    const T * temperature = ingredientColumns[0];
+    const T factor = pow(p0 / ingredientColumns[1][0], kappa_);
+#pragma omp simd
+    for (atlas::idx_t level = 0; level < nlevels; ++level) {
+        potential_temperature[level] = temperature[level] * factor;
+    }
+}
+
 }  // namespace vader
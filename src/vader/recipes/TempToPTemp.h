@@ -8,6 +8,7 @@
 #ifndef SRC_VADER_RECIPES_TEMPTOPTEMP_H_
 #define SRC_VADER_RECIPES_TEMPTOPTEMP_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -37,6 +38,10 @@ class TempToPTempParameters : public RecipeParametersBase {
  *           p0 and kappa can be specified via the constructor configuration.
  *           If they are not, the code will attempt to provide default values.
  *           (See https://glossary.ametsoc.org/wiki/Potential_temperature)
+ *
+ *           A p0 deduced from the units of the surface pressure is held in the
+ *           context of each execution, so FieldSets with pressure in Pa and in hPa
+ *           can be processed concurrently.
  */
 class TempToPTemp : public RecipeBase {
  public:
@@ -51,10 +56,26 @@ class TempToPTemp : public RecipeBase {
     // Recipe base class overrides
     std::string name() const override;
     std::vector<std::string> ingredients() const override;
+    RecipeCost cost() const override;
+    std::unique_ptr<RecipeContext> makeContext(const atlas::FieldSet &) const override;
     bool execute(atlas::FieldSet &) override;
+    bool execute(atlas::FieldSet &, const ColumnSelection &) override;
+    bool hasColumnKernel() const override;
+    bool hasFloatColumnKernel() const override;
+    void executeColumn(const RecipeContext &, const double * const *, const atlas::idx_t *,
+                       double *, const atlas::idx_t) const override;
+    void executeColumn(const RecipeContext &, const float * const *, const atlas::idx_t *,
+                       float *, const atlas::idx_t) const override;
 
  private:
-    double p0_;
+    bool deduceP0(const atlas::FieldSet &, double &) const;
+    template <typename T>
+    void computePotentialTemperature(atlas::FieldSet &, const ColumnSelection &,
+                                     const double) const;
+    template <typename T>
+    void computeColumn(const T * const *, T *, const atlas::idx_t, const double) const;
+
+    const double p0_;
     const double kappa_;
 };
 
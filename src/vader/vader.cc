@@ -6,23 +6,74 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "atlas/array.h"
 #include "atlas/field/Field.h"
+#include "eckit/mpi/Comm.h"
+#include "oops/util/abor1_cpp.h"
 #include "oops/util/Logger.h"
 #include "oops/util/Timer.h"
 #include "vader/cookbook.h"
+#include "vader/PlanScheduler.h"
 #include "vader/vader.h"
 
 namespace vader {
 
+namespace {
+
+/// Name of the statistics file of this MPI task: the 'stats file' parameter, followed by
+/// the rank of the task when there are several tasks
+std::string statsFileName(const VaderParameters & parameters) {
+    if (!parameters.statsFile.value()) return "";
+    std::string name = *parameters.statsFile.value();
+    const eckit::mpi::Comm & comm = eckit::mpi::comm();
+    if (comm.size() > 1) name += "." + std::to_string(comm.rank());
+    return name;
+}
+
+/// Writes one line of statistics to a file. The first line written to a file by the
+/// process replaces its contents, the following ones (from other Vaders) are appended.
+void writeStatsLine(const std::string & fileName, const std::string & line) {
+    static std::mutex mutex;
+    static std::set<std::string> written;
+    std::lock_guard<std::mutex> lock(mutex);
+    const bool append = !written.insert(fileName).second;
+    std::ofstream statsFile(fileName, append ? std::ios::app : std::ios::trunc);
+    statsFile << line << std::endl;
+    if (!statsFile) {
+        oops::Log::warning() << "Vader could not write statistics to " << fileName << std::endl;
+    }
+}
+
+}  // namespace
+
 // ------------------------------------------------------------------------------------------------
 Vader::~Vader() {
+    // Statistics of this Vader's recipes, and of the mo kernels for the whole process
+    std::ostringstream json;
+    json << "{\"recipes\": ";
+    stats_.writeJSON(json);
+    json << ", \"kernels\": ";
+    StatsRegistry::global().writeJSON(json);
+    json << "}";
+    if (!stats_.empty()) {
+        oops::Log::stats() << "Vader statistics: " << json.str() << std::endl;
+    }
+    if (!statsFile_.empty()) writeStatsLine(statsFile_, json.str());
     oops::Log::trace() << "Vader::~Vader done" << std::endl;
 }
 // ------------------------------------------------------------------------------------------------
@@ -33,6 +84,7 @@ void Vader::createCookbook(std::unordered_map<std::string,
                     allRecpParamWraps) {
     oops::Log::trace() << "entering Vader::createCookbook" << std::endl;
     std::vector<std::unique_ptr<RecipeBase>> recipes;
+    std::vector<std::vector<CookbookEntry>> cookbook;
     for (auto defEntry : definition) {
         recipes.clear();
         for (auto recipeName : defEntry.second) {
@@ -56,12 +108,30 @@ void Vader::createCookbook(std::unordered_map<std::string,
                                   (RecipeFactory::create(recipeName, *emptyRecipeParams)));
             }
         }
-        cookbook_[defEntry.first] = std::move(recipes);
+        // The products and ingredients of the recipes are added to the variable table
+        // if they are not in it already.
+        const VariableTable::Id product = variables_.intern(defEntry.first);
+        if (product >= cookbook.size()) cookbook.resize(product + 1);
+        cookbook[product].clear();
+        for (auto & recipe : recipes) {
+            CookbookEntry entry;
+            for (const auto & ingredient : recipe->ingredients()) {
+                entry.ingredients.push_back(variables_.intern(ingredient));
+            }
+            entry.cost = recipe->cost().weight();
+            entry.recipe = std::move(recipe);
+            cookbook[product].push_back(std::move(entry));
+        }
     }
+    cookbook.resize(variables_.size());
+    cookbook_ = std::move(cookbook);
     oops::Log::trace() << "leaving Vader::createCookbook" << std::endl;
 }
 // ------------------------------------------------------------------------------------------------
-Vader::Vader(const VaderParameters & parameters) {
+Vader::Vader(const VaderParameters & parameters)
+    : concurrentRecipes_(parameters.concurrentRecipes.value()),
+      fuseColumnKernels_(parameters.fuseColumnKernels.value()),
+      statsFile_(statsFileName(parameters)) {
     util::Timer timer(classname(), "Vader");
     // TODO(vahl): Parameters can alter the default cookbook here
     std::unordered_map<std::string, std::vector<std::string>> definition =
@@ -81,6 +151,92 @@ Vader::Vader(const VaderParameters & parameters) {
     } else {
         createCookbook(definition, *parameters.recipeParams.value());
     }
+    buildCookbookGraph();
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Build Cookbook Graph
+*
+* \details **buildCookbookGraph** turns the cookbook into a dependency graph between
+* variables, in which a variable depends on the ingredients of every recipe that
+* produces it. It:
+* * Removes recipes that list their own product as an ingredient, since they can
+*   never be used
+* * Finds the cycles in the graph (as its strongly connected components, using
+*   Tarjan's algorithm). Cycles are reported, and the variables in them are
+*   remembered so the planner can guard against them.
+*
+* This is done once, when Vader is constructed.
+*/
+void Vader::buildCookbookGraph() {
+    oops::Log::trace() << "entering Vader::buildCookbookGraph" << std::endl;
+    const std::size_t nvars = variables_.size();
+    const std::size_t unset = static_cast<std::size_t>(-1);
+
+    for (VariableTable::Id product = 0; product < nvars; ++product) {
+        auto & recipeList = cookbook_[product];
+        for (auto entry = recipeList.begin(); entry != recipeList.end(); ) {
+            if (std::find(entry->ingredients.begin(), entry->ingredients.end(), product)
+                    != entry->ingredients.end()) {
+                oops::Log::error() << "Error: Ingredient list for " << entry->recipe->name() <<
+                    " contains the target. The recipe is removed from the cookbook." << std::endl;
+                entry = recipeList.erase(entry);
+                continue;
+            }
+            ++entry;
+        }
+    }
+
+    // Tarjan's algorithm. Components are completed in reverse topological order, i.e.
+    // a component is completed after all the components its ingredients belong to.
+    std::vector<std::size_t> index(nvars, unset);
+    std::vector<std::size_t> lowlink(nvars, 0);
+    std::vector<bool> onStack(nvars, false);
+    std::vector<VariableTable::Id> stack;
+    std::vector<std::vector<VariableTable::Id>> components;
+    std::size_t nextIndex = 0;
+
+    std::function<void(VariableTable::Id)> strongConnect = [&](VariableTable::Id var) {
+        index[var] = lowlink[var] = nextIndex++;
+        stack.push_back(var);
+        onStack[var] = true;
+        for (const auto & entry : cookbook_[var]) {
+            for (auto ingredient : entry.ingredients) {
+                if (index[ingredient] == unset) {
+                    strongConnect(ingredient);
+                    lowlink[var] = std::min(lowlink[var], lowlink[ingredient]);
+                } else if (onStack[ingredient]) {
+                    lowlink[var] = std::min(lowlink[var], index[ingredient]);
+                }
+            }
+        }
+        if (lowlink[var] == index[var]) {
+            std::vector<VariableTable::Id> members;
+            VariableTable::Id member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                onStack[member] = false;
+                members.push_back(member);
+            } while (member != var);
+            components.push_back(members);
+        }
+    };
+    for (VariableTable::Id var = 0; var < nvars; ++var) {
+        if (index[var] == unset && !cookbook_[var].empty()) strongConnect(var);
+    }
+
+    cyclicVars_ = VariableTable::Set(nvars);
+    for (std::size_t comp = 0; comp < components.size(); ++comp) {
+        if (components[comp].size() > 1) {
+            oops::Log::warning() << "Warning: Vader cookbook contains a cycle between:";
+            for (auto var : components[comp]) {
+                oops::Log::warning() << " " << variables_.name(var);
+                cyclicVars_.set(var);
+            }
+            oops::Log::warning() << std::endl;
+        }
+    }
+    oops::Log::trace() << "leaving Vader::buildCookbookGraph" << std::endl;
 }
 // ------------------------------------------------------------------------------------------------
 /*! \brief Change Variable
@@ -98,177 +254,837 @@ Vader::Vader(const VaderParameters & parameters) {
 * variables it was able to populate will have been removed from the neededVars
 * list. Any variable names remaining in neededVars remain unpopulated.
 *
+* This is equivalent to calling **compile** followed by the **changeVar** overload
+* that takes a ChangeVarPlan. Callers that change variables repeatedly with the
+* same field layout should compile the plan once and reuse it.
+*
+* Callers that only need the variables at some columns (e.g. those close to
+* observations) can pass a ColumnSelection: the recipes then only compute those
+* columns, and the values of the populated fields at other columns are undefined.
+*
 * \param[in,out] afieldset This is the FieldSet described above
 * \param[in,out] neededVars Names of unpopulated Fields in afieldset
+* \param[in] columns Columns to compute (by default, all of them)
 * \returns List of variables VADER was able to populate
 *
 */
 oops::Variables Vader::changeVar(atlas::FieldSet & afieldset,
-                                 oops::Variables & neededVars) const {
+                                 oops::Variables & neededVars,
+                                 const ColumnSelection & columns) const {
     util::Timer timer(classname(), "changeVar");
     oops::Log::trace() << "entering Vader::changeVar " << std::endl;
     oops::Log::debug() << "neededVars passed to Vader::changeVar: " << neededVars << std::endl;
 
-    oops::Variables varsProduced(neededVars);
+    const ChangeVarPlan plan = compile(afieldset.field_names(), neededVars);
+    oops::Variables varsProduced = changeVar(afieldset, plan, columns);
+    neededVars -= varsProduced;
+
+    oops::Log::debug() << "neededVars remaining after Vader::changeVar: " << neededVars
+        << std::endl;
+    oops::Log::trace() << "leaving Vader::changeVar" << std::endl;
+    return varsProduced;
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Compile
+*
+* \details **compile** runs the Vader planning algorithm once for a given field
+* layout and returns the resulting ChangeVarPlan. The plan holds the recipes to be
+* executed, already looked up in the cookbook, so that it can be executed any
+* number of times by the **changeVar** overload that takes a plan.
+*
+* \param[in] fieldNames Names of all the fields (populated or not) in the FieldSets
+*            the plan will be executed on
+* \param[in] neededVars Names of the unpopulated fields
+* \returns The compiled plan. Its producedVars() are the variables Vader is able
+*          to populate.
+*
+*/
+ChangeVarPlan Vader::compile(const std::vector<std::string> & fieldNames,
+                             const oops::Variables & neededVars) const {
+    util::Timer timer(classname(), "compile");
+    oops::Log::trace() << "entering Vader::compile " << std::endl;
+
+    ChangeVarPlan plan;
+    plan.fieldNames_ = fieldNames;
 
-    auto fieldSetFieldNames = afieldset.field_names();
-    // Loop through all the requested fields in neededVars
-    // Since neededVars can be modified by planVariable and planVariable calls
-    // itself recursively, we make a copy of the list here before we start.
-    std::vector<std::string> targetVariables{neededVars.variables()};
-    std::vector<std::pair<std::string, std::string>> plan;
+    // Planning works on sets of variable ids. Since remainingVars is modified by
+    // planVariable and planVariable calls itself recursively, we loop over the
+    // original list of needed variables.
+    // Variables that are not allocated are needed too: they can only be used as
+    // ingredients once a recipe has been planned to make them in a scratch field.
+    const VariableTable::Set allocatedVars = variables_.set(fieldNames);
+    VariableTable::Set remainingVars = variables_.set(neededVars.variables()) | ~allocatedVars;
+    std::vector<RecipeChoice> choices(variables_.size());
 
-    for (auto targetVariable : targetVariables) {
+    for (const auto & targetVariable : neededVars.variables()) {
+        const VariableTable::Id targetId = variables_.find(targetVariable);
+        if (targetId == VariableTable::npos) {
+            oops::Log::debug() << "Vader cookbook does not contain a recipe for: "
+                << targetVariable << std::endl;
+            continue;
+        }
+        if (!allocatedVars[targetId]) {
+            oops::Log::debug() << "Field '" << targetVariable <<
+                "' is not allocated the fieldset. Vader cannot make it." << std::endl;
+            continue;
+        }
         oops::Log::debug() <<
-            "Vader::changeVar calling Vader::planVariable for: "
+            "Vader::compile calling Vader::planVariable for: "
             << targetVariable << std::endl;
-        planVariable(afieldset, neededVars, targetVariable, plan);
+        // Costs depend on the variables planned for the previous targets, which are free
+        std::fill(choices.begin(), choices.end(), RecipeChoice());
+        planVariable(allocatedVars, remainingVars, targetId, choices, plan.steps_);
     }
-    executePlanNL(afieldset, plan);
+    plan.buildDependencyGraph(fuseColumnKernels_);
 
-    oops::Log::debug() << "neededVars remaining after Vader::changeVar: " << neededVars
-        << std::endl;
-    varsProduced -= neededVars;
-    oops::Log::trace() << "leaving Vader::changeVar" << std::endl;
+    for (const auto & targetVariable : neededVars.variables()) {
+        const VariableTable::Id targetId = variables_.find(targetVariable);
+        if (targetId != VariableTable::npos && allocatedVars[targetId] &&
+            !remainingVars[targetId]) {
+            plan.producedVars_.push_back(targetVariable);
+        }
+    }
+
+    oops::Log::debug() << "Vader::compile created " << plan << std::endl;
+    oops::Log::trace() << "leaving Vader::compile" << std::endl;
+    return plan;
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Change Variable (compiled plan)
+*
+* \details This overload of **changeVar** executes a plan previously created by
+* **compile**. No planning is done: the recipes in the plan are executed in order.
+* The FieldSet must contain all the fields the plan was compiled against.
+*
+* \param[in,out] afieldset FieldSet containing ingredients and the fields to populate
+* \param[in] plan A plan created by this Vader's compile method
+* \param[in] columns Columns to compute (by default, all of them)
+* \returns List of variables VADER populated
+*
+*/
+oops::Variables Vader::changeVar(atlas::FieldSet & afieldset,
+                                 const ChangeVarPlan & plan,
+                                 const ColumnSelection & columns) const {
+    util::Timer timer(classname(), "changeVar");
+    oops::Log::trace() << "entering Vader::changeVar(plan) " << std::endl;
+
+    executePlanNL({&afieldset}, plan, columns);
+
+    oops::Log::trace() << "leaving Vader::changeVar(plan)" << std::endl;
+    return plan.producedVars();
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Change Variable (ensemble)
+*
+* \details This overload of **changeVar** populates the same variables in every
+* member of a batch (e.g. an ensemble) of FieldSets. All the members must hold the
+* same fields, laid out in the same way. The plan is compiled once for the batch,
+* each recipe is set up once for the batch and then executed for all the members
+* together (see executePlanNL), so constant inputs of the recipes are only loaded
+* once.
+*
+* \param[in,out] members FieldSets containing ingredients and the fields to populate
+* \param[in,out] neededVars Names of unpopulated Fields in the members
+* \param[in] columns Columns to compute in every member (by default, all of them)
+* \returns List of variables VADER was able to populate in every member
+*
+*/
+oops::Variables Vader::changeVar(std::vector<atlas::FieldSet *> & members,
+                                 oops::Variables & neededVars,
+                                 const ColumnSelection & columns) const {
+    util::Timer timer(classname(), "changeVar");
+    oops::Log::trace() << "entering Vader::changeVar(members) " << std::endl;
+    if (members.empty()) return oops::Variables();
+
+    const ChangeVarPlan plan = compile(members.front()->field_names(), neededVars);
+    oops::Variables varsProduced = changeVar(members, plan, columns);
+    neededVars -= varsProduced;
+
+    oops::Log::trace() << "leaving Vader::changeVar(members)" << std::endl;
+    return varsProduced;
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Change Variable (ensemble, compiled plan)
+*
+* \details Executes a plan previously created by **compile** for every member of a
+* batch of FieldSets. Every member must hold the fields the plan was compiled
+* against.
+*
+* \param[in,out] members FieldSets containing ingredients and the fields to populate
+* \param[in] plan A plan created by this Vader's compile method
+* \param[in] columns Columns to compute in every member (by default, all of them)
+* \returns List of variables VADER populated
+*
+*/
+oops::Variables Vader::changeVar(std::vector<atlas::FieldSet *> & members,
+                                 const ChangeVarPlan & plan,
+                                 const ColumnSelection & columns) const {
+    util::Timer timer(classname(), "changeVar");
+    oops::Log::trace() << "entering Vader::changeVar(members, plan) " << std::endl;
+
+    for (const atlas::FieldSet * member : members) {
+        for (const auto & fieldName : plan.fieldNames()) {
+            if (!member->has_field(fieldName)) {
+                oops::Log::error() << "Vader::changeVar: field " << fieldName <<
+                    " is missing from an ensemble member." << std::endl;
+                ABORT("Vader::changeVar: ensemble members do not have the same fields");
+            }
+        }
+    }
+    executePlanNL(members, plan, columns);
+
+    oops::Log::trace() << "leaving Vader::changeVar(members, plan)" << std::endl;
+    return plan.producedVars();
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Change Variable (incremental)
+*
+* \details This variant of **changeVar** is meant for callers that change variables
+* repeatedly in the same FieldSet while only some of its fields change in between
+* (e.g. successive outer loops). For every FieldSet it is called with, Vader keeps
+* the plan it executed and a stamp of each field the plan read or wrote. On the
+* next call with the same FieldSet, fields and needed variables, only the recipes
+* for which an ingredient or the product changed since then, or which depend on such
+* a recipe, are executed again. Intermediates in scratch fields are not kept, so the
+* recipes making those needed by the recipes executed again are executed too.
+*
+* A field stamp is its storage and its contents. Fields that have an integer
+* "version" in their metadata are assumed to have the same contents as long as the
+* version does not change, and the version of products that carry one is
+* incremented when they are recomputed. The values of other fields are hashed,
+* which costs one read of each ingredient and product per call.
+*
+* Calls for different FieldSets run concurrently, calls for the same FieldSet one
+* after the other. Vader holds a reference to every FieldSet it keeps a record for:
+* the record is dropped by **forgetIncremental**, or by the next call of
+* changeVarIncremental once Vader holds the only reference left to the FieldSet.
+*
+* \param[in,out] afieldset FieldSet containing ingredients and the fields to populate
+* \param[in,out] neededVars Names of unpopulated Fields in afieldset
+* \returns List of variables VADER was able to populate
+*
+*/
+oops::Variables Vader::changeVarIncremental(atlas::FieldSet & afieldset,
+                                            oops::Variables & neededVars) const {
+    util::Timer timer(classname(), "changeVarIncremental");
+    oops::Log::trace() << "entering Vader::changeVarIncremental " << std::endl;
+    std::shared_ptr<IncrementalState> record;
+    {
+        std::lock_guard<std::mutex> lock(incrementalMutex_);
+        // FieldSets nobody else holds can never be passed again
+        for (auto it = incrementalStates_.begin(); it != incrementalStates_.end(); ) {
+            if (it->second->fieldset.get()->owners() == 1) {
+                it = incrementalStates_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        std::shared_ptr<IncrementalState> & entry = incrementalStates_[afieldset.get()];
+        if (!entry) {
+            entry = std::make_shared<IncrementalState>();
+            entry->fieldset = afieldset;
+        }
+        record = entry;
+    }
+    IncrementalState & state = *record;
+    std::lock_guard<std::mutex> stateLock(state.mutex);
+
+    if (state.plan.fieldNames() != afieldset.field_names() ||
+        state.neededVars != neededVars.variables()) {
+        state.neededVars = neededVars.variables();
+        state.plan = compile(afieldset.field_names(), neededVars);
+        state.stamps.clear();
+    }
+    const auto & steps = state.plan.steps();
+
+    // Stamps of the fields of the FieldSet the plan uses, as they are now
+    std::unordered_map<std::string, FieldStamp> current;
+    for (const auto & step : steps) {
+        for (const auto & ingredient : step.recipe->ingredients()) {
+            if (afieldset.has_field(ingredient) && current.count(ingredient) == 0) {
+                current.emplace(ingredient, stamp(afieldset.field(ingredient)));
+            }
+        }
+        if (!step.scratch) current.emplace(step.variable, stamp(afieldset.field(step.variable)));
+    }
+    auto changed = [&](const std::string & name) {
+        auto it = state.stamps.find(name);
+        return it == state.stamps.end() || it->second != current.at(name);
+    };
+
+    // A step is executed again if its inputs or its product changed, or if a step it
+    // depends on is executed again; scratch steps are executed again when one of their
+    // dependents is.
+    std::vector<bool> dirty(steps.size(), false);
+    for (std::size_t i = 0; i < steps.size(); ++i) {
+        const ChangeVarPlan::Step & step = steps[i];
+        dirty[i] = !step.scratch && changed(step.variable);
+        for (const auto & ingredient : step.recipe->ingredients()) {
+            if (current.count(ingredient) > 0 && changed(ingredient)) dirty[i] = true;
+        }
+        for (auto dependency : step.dependencies) {
+            if (dirty[dependency]) dirty[i] = true;
+        }
+    }
+    for (std::size_t i = steps.size(); i-- > 0;) {
+        if (!dirty[i]) continue;
+        for (auto dependency : steps[i].dependencies) {
+            if (steps[dependency].scratch) dirty[dependency] = true;
+        }
+    }
+
+    ChangeVarPlan update;
+    update.fieldNames_ = state.plan.fieldNames();
+    update.producedVars_ = state.plan.producedVars();
+    for (std::size_t i = 0; i < steps.size(); ++i) {
+        if (dirty[i]) update.steps_.push_back(steps[i]);
+    }
+    update.buildDependencyGraph(fuseColumnKernels_);
+    oops::Log::debug() << "Vader::changeVarIncremental executing " << update.size() << " of "
+        << steps.size() << " step(s)" << std::endl;
+    if (!update.empty()) executePlanNL({&afieldset}, update, ColumnSelection());
+
+    for (const auto & step : update.steps()) {
+        if (step.scratch) continue;
+        atlas::Field product = afieldset.field(step.variable);
+        int version;
+        if (product.metadata().get("version", version)) {
+            product.metadata().set("version", version + 1);
+        }
+        current[step.variable] = stamp(product);
+    }
+    state.stamps = std::move(current);
+
+    oops::Variables varsProduced = state.plan.producedVars();
+    neededVars -= varsProduced;
+    oops::Log::trace() << "leaving Vader::changeVarIncremental" << std::endl;
     return varsProduced;
 }
 // ------------------------------------------------------------------------------------------------
+void Vader::forgetIncremental(const atlas::FieldSet & afieldset) const {
+    std::lock_guard<std::mutex> lock(incrementalMutex_);
+    incrementalStates_.erase(afieldset.get());
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Field Stamp
+*
+* \details Stamp of the current contents of a field for changeVarIncremental: its
+* "version" metadata if it has one, otherwise a hash of its values.
+*/
+Vader::FieldStamp Vader::stamp(atlas::Field field) {
+    FieldStamp fieldStamp{field.storage(), field.bytes(), 0};
+    int version;
+    if (field.metadata().get("version", version)) {
+        fieldStamp.contents = static_cast<std::uint64_t>(version);
+        return fieldStamp;
+    }
+    // FNV-1a over 64-bit words
+    const std::uint64_t prime = 0x100000001b3ULL;
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    const unsigned char * bytes = static_cast<const unsigned char *>(fieldStamp.storage);
+    std::size_t i = 0;
+    for (; i + sizeof(std::uint64_t) <= fieldStamp.bytes; i += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < fieldStamp.bytes; ++i) hash = (hash ^ bytes[i]) * prime;
+    fieldStamp.contents = hash;
+    return fieldStamp;
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Choose Recipe
+*
+* \details **chooseRecipe** finds the cheapest way Vader has to make a variable. It:
+* * Checks the cookbook for recipes for the desired variable (the targetVariable)
+* * Skips the recipes that are not viable (see RecipeBase::isViable)
+* * Checks each recipe to see if its required ingredients are available. Ingredients
+*   that are not needed (they are populated already, or planned) cost nothing; if an
+*   ingredient is missing, it recursively calls itself to find the cheapest way to
+*   make it.
+* * Keeps the viable recipe for which the estimated cost of the recipe plus the cost
+*   of making its missing ingredients is the lowest (the first such recipe in the
+*   cookbook in case of a tie).
+*
+* Nothing is added to the plan. The outcome for every variable is memoized in
+* choices, so each variable is only searched for once. A variable that is found
+* again while it is still being searched for is part of a cycle in the cookbook, and
+* is treated as not available on that path. Failures for variables in cycles are not
+* memoized, since they may depend on the path taken.
+*
+* \param[in] neededVars Unpopulated fields and variables not in the fieldset
+* \param[in] targetVariable variable the cheapest recipe is searched for
+* \param[in,out] choices recipe chosen for (and state of) every variable in the search
+* \return boolean 'true' if a viable recipe was found for targetVariable, else false
+*
+*/
+bool Vader::chooseRecipe(const VariableTable::Set & neededVars,
+                         const VariableTable::Id targetVariable,
+                         std::vector<RecipeChoice> & choices) const {
+    const std::string & targetName = variables_.name(targetVariable);
+    RecipeChoice & choice = choices[targetVariable];
+
+    if (!neededVars[targetVariable] || choice.state == PlanState::planned) return true;
+    if (choice.state == PlanState::unavailable || choice.state == PlanState::inProgress) {
+        oops::Log::debug() << targetName << (choice.state == PlanState::inProgress ?
+            " is already being planned (cookbook cycle)." : " is known to be unavailable.") <<
+            std::endl;
+        return false;
+    }
+    choice.state = PlanState::inProgress;
+
+    if (cookbook_[targetVariable].empty()) {
+        oops::Log::debug() << "Vader cookbook does not contain a recipe for: "
+            << targetName << std::endl;
+    }
+    for (const auto & entry : cookbook_[targetVariable]) {
+        if (!entry.recipe->isViable()) {
+            oops::Log::debug() << "Recipe " << entry.recipe->name() << " is not viable." <<
+                std::endl;
+            continue;
+        }
+        oops::Log::debug() << "Checking to see if we have ingredients for recipe: " <<
+            entry.recipe->name() << std::endl;
+        bool haveIngredients = true;
+        double cost = entry.cost;
+        for (auto ingredient : entry.ingredients) {
+            if (!neededVars[ingredient]) continue;
+            oops::Log::debug() << "ingredient " << variables_.name(ingredient) <<
+                " not found. Recursively checking if Vader can make it." << std::endl;
+            haveIngredients = chooseRecipe(neededVars, ingredient, choices);
+            if (!haveIngredients) {
+                oops::Log::debug() << "ingredient " << variables_.name(ingredient) <<
+                    " is not available." << std::endl;
+                break;
+            }
+            cost += choices[ingredient].cost;
+        }
+        if (!haveIngredients) continue;
+        oops::Log::debug() << "Recipe " << entry.recipe->name() << " can make " << targetName <<
+            " with estimated cost " << cost << std::endl;
+        if (choice.entry == nullptr || cost < choice.cost) {
+            choice.entry = &entry;
+            choice.cost = cost;
+        }
+    }
+
+    if (choice.entry != nullptr) {
+        choice.state = PlanState::planned;
+    } else {
+        choice.state = cyclicVars_[targetVariable] ? PlanState::unvisited
+                                                   : PlanState::unavailable;
+    }
+    return choice.entry != nullptr;
+}
+// ------------------------------------------------------------------------------------------------
 /*! \brief Plan Variable
 *
 * \details **planVariable** contains Vader's primary algorithm for attempting to
 * populate an unpopulated field. It:
-* * Checks the cookbook for recipes for the desired field (the targetVariable)
-* * Checks each recipe to see if its required ingredients have been provided
-* * If an ingredient is missing, recursively calls itself to attempt to get it
-* * Adds the variable and recipe name to the "recipeExecutionPlan" if the recipe is viable.
+* * Chooses the cheapest viable chain of recipes for the desired field (the
+*   targetVariable) with chooseRecipe
+* * Recursively plans the recipes making the missing ingredients of the chosen recipe
+* * Adds the variable and the chosen recipe to the plan, once and after the recipes
+*   making its ingredients
 * * If successful, removes the targetVariable from neededVars and returns 'true'
 *
-* \param[in,out] afieldset A fieldset containg both populated and unpopulated fields
-* \param[in,out] neededVars Names of unpopulated Fields in afieldset
+* Variables that are not allocated in the fieldset are in neededVars too. They can
+* be planned as ingredients of other recipes, in which case their step is marked as
+* a scratch step: Vader allocates the field while the plan is executed.
+*
+* \param[in] allocatedVars Both populated and unpopulated fields of the fieldset
+* \param[in,out] neededVars Unpopulated fields and variables not in the fieldset
 * \param[in] targetVariable variable name this instance is trying to populate
+* \param[in,out] choices recipe chosen for every variable (see chooseRecipe)
 * \param[in,out] plan ordered list of viable recipes that will get exectued later
 * \return boolean 'true' if it successfully creates a plan for targetVariable, else false
 *
 */
-bool Vader::planVariable(atlas::FieldSet & afieldset,
-                         oops::Variables & neededVars,
-                         const std::string targetVariable,
-                         std::vector<std::pair<std::string, std::string>> & plan) const {
-    bool variablePlanned = false;
+bool Vader::planVariable(const VariableTable::Set & allocatedVars,
+                         VariableTable::Set & neededVars,
+                         const VariableTable::Id targetVariable,
+                         std::vector<RecipeChoice> & choices,
+                         std::vector<ChangeVarPlan::Step> & plan) const {
+    const std::string & targetName = variables_.name(targetVariable);
 
-    oops::Log::trace() << "entering Vader::planVariable for variable: " << targetVariable <<
+    oops::Log::trace() << "entering Vader::planVariable for variable: " << targetName <<
         std::endl;
 
-    auto fieldSetFieldNames = afieldset.field_names();
-
-    if (std::find(fieldSetFieldNames.begin(),
-        fieldSetFieldNames.end(), targetVariable) == fieldSetFieldNames.end()) {
-        oops::Log::debug() << "Field '" << targetVariable <<
-            "' is not allocated the fieldset. Vader cannot make it." << std::endl;
-        oops::Log::trace() << "leaving Vader::planVariable for variable: " <<
-            targetVariable << std::endl;
-        return false;
-    }
-
     // Since this function is called recursively, make sure targetVariable is
     // still needed
-    if (!neededVars.has(targetVariable)) {
-        oops::Log::debug() << targetVariable <<
+    if (!neededVars[targetVariable]) {
+        oops::Log::debug() << targetName <<
             " is no longer in the variable list neededVars." << std::endl;
         oops::Log::trace() << "leaving Vader::planVariable for variable: "
-            << targetVariable << std::endl;
+            << targetName << std::endl;
         return true;
     }
 
-    auto recipeList = cookbook_.find(targetVariable);
+    if (!chooseRecipe(neededVars, targetVariable, choices)) {
+        oops::Log::debug() << "Vader cannot make " << targetName << std::endl;
+        oops::Log::trace() << "leaving Vader::planVariable for variable: "
+            << targetName << std::endl;
+        return false;
+    }
 
-    // If recipeList is found, recipeList->second is a vector of unique_ptr's
-    // to Recipe objects that produce 'variableName'
-    if ((recipeList != cookbook_.end()) && !recipeList->second.empty()) {
-        oops::Log::debug() <<
-            "Vader cookbook contains at least one recipe for '" << targetVariable << "'" <<
-            std::endl;
-        for (int i=0; i < recipeList->second.size(); ++i) {
-            oops::Log::debug() << "Checking to see if we have ingredients for recipe: " <<
-                recipeList->second[i]->name() << std::endl;
-            bool haveIngredient = false;
-            for (auto ingredient : recipeList->second[i]->ingredients()) {
-                if (ingredient == targetVariable) {
-                    oops::Log::error() << "Error: Ingredient list for " <<
-                        recipeList->second[i]->name() << " contains the target." << std::endl;
-                    // This could cause infinite recursion if we didn't check.
-                    // TODO(vahl): infinite recursion probably still possible
-                    //       with badly-constructed cookbook.
-                    break;
-                }
-                haveIngredient =
-                    (std::find(fieldSetFieldNames.begin(), fieldSetFieldNames.end(), ingredient)
-                        != fieldSetFieldNames.end()) && (!neededVars.has(ingredient));
-                if (!haveIngredient) {
-                    oops::Log::debug() << "ingredient " << ingredient <<
-                        " not found. Recursively checking if Vader can make it." << std::endl;
-                    haveIngredient = planVariable(afieldset, neededVars, ingredient, plan);
-                }
-                oops::Log::debug() << "ingredient " << ingredient <<
-                    (haveIngredient ? " is" : " is not") << " available." << std::endl;
-                if (!haveIngredient) break;
-            }
-            if (haveIngredient) {
-                oops::Log::debug() <<
-                    "All ingredients are in the fieldset. Adding recipe to recipeExecutionPlan." <<
-                    std::endl;
-                plan.push_back(std::pair<std::string, std::string> ({targetVariable,
-                                                                  recipeList->second[i]->name()}));
-                variablePlanned = true;
-                neededVars -= targetVariable;
-            } else {
-                oops::Log::debug() << "Do not have all the ingredients for this recipe." <<
-                    std::endl;
-            }
-        }
-    } else {
-        oops::Log::debug() << "Vader cookbook does not contain a recipe for: "
-            << targetVariable << std::endl;
+    // Ingredients of the chosen recipe were chosen before it, so this terminates
+    const CookbookEntry & entry = *choices[targetVariable].entry;
+    for (auto ingredient : entry.ingredients) {
+        const bool ingredientPlanned = planVariable(allocatedVars, neededVars, ingredient,
+                                                    choices, plan);
+        ASSERT(ingredientPlanned);
     }
-    oops::Log::trace() << "leaving Vader::planVariable for variable: " << targetVariable <<
+    oops::Log::debug() << "Adding recipe " << entry.recipe->name() << " for " << targetName <<
+        " to recipeExecutionPlan (estimated cost " << choices[targetVariable].cost << ")." <<
+        std::endl;
+    plan.push_back(ChangeVarPlan::Step{targetName, entry.recipe.get(),
+                                       !allocatedVars[targetVariable]});
+    neededVars.reset(targetVariable);
+
+    oops::Log::trace() << "leaving Vader::planVariable for variable: " << targetName <<
         std::endl;
-    return variablePlanned;
+    return true;
 }
 
 /*! \brief Execute Plan (non-linear)
 *
-* \details **executePlanNL** calls, in order, the 'execute' (non-linear) method of the
-* recipes specified in the recipeExecutionPlan that is passed in. (The recipeExecutionPlan is
-* created through calls to planVariable.)
+* \details **executePlanNL** calls the 'execute' (non-linear) method of the
+* recipes specified in the plan that is passed in. (The plan is created by compile,
+* through calls to planVariable.) A recipe is only executed once all the recipes
+* producing its ingredients have been executed. Unless 'concurrent recipes' is
+* turned off in the parameters, recipes that do not depend on each other may be
+* executed at the same time.
 *
-* \param[in,out] afieldset A fieldset containg both populated and unpopulated fields
-* \param[in] recipeExecutionPlan ordered list of recipes that are to be exectued
+* The plan is executed for every member of a batch of FieldSets with the same
+* layout (a single FieldSet is a batch of one). Each stage runs for all the members
+* before the stages depending on it start: the recipes are set up once, on the
+* first member, and then executed for all members with executeBatch, or with their
+* column kernels in a single sweep over the columns of all the members (see
+* useColumnKernels).
+*
+* Each stage is executed on FieldSets of its own, holding only the ingredients
+* and products of its recipes, so that the recipes never see (and concurrent stages
+* never modify) the caller's FieldSets themselves. The products of scratch steps are
+* acquired from the scratch arena when their stage starts, and are released back
+* to the arena when the last stage using them as an ingredient has finished, so
+* they never appear in the caller's FieldSets.
+*
+* \param[in,out] members FieldSets containg both populated and unpopulated fields
+* \param[in] plan compiled plan holding the recipes to be exectued
+* \param[in] columns columns to compute (recipes may leave the other columns untouched)
 *
 */
-void Vader::executePlanNL(atlas::FieldSet & afieldset,
-            const std::vector<std::pair<std::string, std::string>> & recipeExecutionPlan) const {
+void Vader::executePlanNL(const std::vector<atlas::FieldSet *> & members,
+                          const ChangeVarPlan & plan,
+                          const ColumnSelection & columns) const {
     oops::Log::trace() << "entering Vader::executePlanNL" <<  std::endl;
-    // We must get the recipes specified in the recipeExecutionPlan out of the cookbook,
-    // where they live
-    for (auto varPlan : recipeExecutionPlan) {
-        oops::Log::debug() << "Attempting to calculate variable " << varPlan.first <<
-            " using recipe with name: " << varPlan.second << std::endl;
-        ASSERT(afieldset.has_field(varPlan.first));
-        auto recipeList = cookbook_.find(varPlan.first);
-        size_t recipeIndex = 0;
-        while (recipeIndex < recipeList->second.size() &&
-               recipeList->second[recipeIndex]->name() != varPlan.second) recipeIndex++;
-        ASSERT(recipeIndex < recipeList->second.size());
-        for (auto ingredient :  recipeList->second[recipeIndex]->ingredients()) {
-            ASSERT(afieldset.has_field(ingredient));
+    const auto & steps = plan.steps();
+    const std::size_t nmembers = members.size();
+    std::vector<std::vector<atlas::Field>> scratchFields(steps.size());
+    std::unique_ptr<std::atomic<std::size_t>[]>
+        pendingConsumers(new std::atomic<std::size_t>[steps.size()]);
+    for (std::size_t i = 0; i < steps.size(); ++i) {
+        pendingConsumers[i] = steps[i].dependents.size();
+    }
+
+    auto executeStep = [this, &columns](std::vector<atlas::FieldSet> & stageFields,
+                                        const ChangeVarPlan::Step & step) {
+        oops::Log::debug() << "Attempting to calculate variable " << step.variable <<
+            " using recipe with name: " << step.recipe->name() << std::endl;
+        ScopedKernelTimer timer(step.recipe->name(), columns, stats_);
+        std::size_t points = 0;
+        for (const auto & fields : stageFields) {
+            for (const auto & ingredient : step.recipe->ingredients()) {
+                timer.reads(fields.field(ingredient));
+            }
+            const atlas::Field product = fields.field(step.variable);
+            timer.writes(product);
+            points += product.levels() * columns.size(product.shape(0));
         }
-        if (recipeList->second[recipeIndex]->requiresSetup()) {
-            recipeList->second[recipeIndex]->setup(afieldset);
+        timer.points(points);
+        const RecipeBase::SetupLock setupLock = step.recipe->ensureSetup(stageFields.front());
+        ASSERT(setupLock.owns_lock());
+        bool recipeSuccess;
+        if (stageFields.size() == 1) {
+            recipeSuccess = step.recipe->execute(stageFields.front(), columns);
+        } else {
+            std::vector<atlas::FieldSet *> stageMembers;
+            for (auto & fields : stageFields) stageMembers.push_back(&fields);
+            recipeSuccess = step.recipe->executeBatch(stageMembers, columns);
         }
-        const bool recipeSuccess = recipeList->second[recipeIndex]->execute(afieldset);
         ASSERT(recipeSuccess);  // At least for now, we'll require the execution to be successful
+    };
+    auto executeStage = [&](const ChangeVarPlan::Stage & stage) {
+        std::vector<atlas::FieldSet> stageFields(nmembers);
+        for (auto i : stage.steps) {
+            const ChangeVarPlan::Step & step = steps[i];
+            for (std::size_t m = 0; m < nmembers; ++m) {
+                atlas::FieldSet & fields = stageFields[m];
+                for (auto dependency : step.dependencies) {
+                    if (!steps[dependency].scratch) continue;
+                    const atlas::Field & ingredient = scratchFields[dependency][m];
+                    if (!fields.has_field(ingredient.name())) fields.add(ingredient);
+                }
+                for (auto ingredient : step.recipe->ingredients()) {
+                    if (fields.has_field(ingredient)) continue;
+                    ASSERT(members[m]->has_field(ingredient));
+                    fields.add(members[m]->field(ingredient));
+                }
+                if (step.scratch) {
+                    if (m == 0) scratchFields[i].resize(nmembers);
+                    scratchFields[i][m] =
+                        scratchArena_.acquire(step.variable,
+                                              step.recipe->productFunctionSpace(fields),
+                                              step.recipe->productLevels(fields),
+                                              step.recipe->productDataType(fields));
+                    fields.add(scratchFields[i][m]);
+                } else {
+                    ASSERT(members[m]->has_field(step.variable));
+                    fields.add(members[m]->field(step.variable));
+                }
+            }
+        }
+
+        if (!useColumnKernels(plan, stage) ||
+            !executeFusedStage(stageFields, plan, stage, columns)) {
+            for (auto i : stage.steps) executeStep(stageFields, steps[i]);
+        }
+
+        for (auto i : stage.steps) {
+            for (auto dependency : steps[i].dependencies) {
+                if (steps[dependency].scratch && pendingConsumers[dependency].fetch_sub(1) == 1) {
+                    for (const auto & field : scratchFields[dependency]) {
+                        scratchArena_.release(field);
+                    }
+                    scratchFields[dependency].clear();
+                }
+            }
+        }
+    };
+
+    PlanScheduler scheduler(plan, executeStage);
+    if (concurrentRecipes_) {
+        scheduler.runConcurrent();
+    } else {
+        scheduler.runSequential();
     }
     oops::Log::trace() << "leaving Vader::executePlanNL" <<  std::endl;
 }
+// ------------------------------------------------------------------------------------------------
+/*! \brief Use Column Kernels
+*
+* \details A stage is evaluated with the column kernels of its recipes when they
+* all have one, which is always the case for fused stages. A stage made of a single
+* recipe with a column kernel is then one parallel sweep over the columns of all
+* the members too.
+*/
+bool Vader::useColumnKernels(const ChangeVarPlan & plan,
+                             const ChangeVarPlan::Stage & stage) const {
+    if (stage.fused()) return true;
+    if (!fuseColumnKernels_) return false;
+    for (auto i : stage.steps) {
+        if (!plan.steps()[i].recipe->hasColumnKernel()) return false;
+    }
+    return true;
+}
+// ------------------------------------------------------------------------------------------------
+/*! \brief Execute Fused Stage
+*
+* \details **executeFusedStage** evaluates the recipes of a stage with their
+* column kernels in a single sweep over the columns of all the members: for each
+* column, the kernels of the stage are called in plan order, so an intermediate
+* variable is consumed while its column is still in cache rather than being streamed
+* through memory once per recipe.
+*
+* The statistics of a stage of several recipes are recorded under the names of the
+* recipes joined by '+'.
+*
+* The fields are accessed directly as contiguous (columns x levels) arrays, and the
+* single or double precision column kernels are used depending on the data type of
+* the fields. The single precision columns of recipes without a single precision
+* kernel are copied to double precision buffers, allocated once per thread. If a field of the stage is not laid out that way, the fields do not
+* all have the same number of columns and the same data type, or the setup of a
+* recipe fails or it cannot make the context of its column kernel (see
+* RecipeBase::makeContext), nothing is executed and false is returned so that the
+* caller falls back to executing the recipes one at a time.
+*
+* \param[in,out] stageFields The stage's FieldSet for each member
+* \param[in] plan compiled plan the stage belongs to
+* \param[in] stage stage to execute
+* \param[in] columns columns to compute
+* \return boolean 'true' if the stage was executed
+*
+*/
+bool Vader::executeFusedStage(std::vector<atlas::FieldSet> & stageFields,
+                              const ChangeVarPlan & plan,
+                              const ChangeVarPlan::Stage & stage,
+                              const ColumnSelection & columns) const {
+    const atlas::Field product =
+        stageFields.front().field(plan.steps()[stage.steps.front()].variable);
+    if (product.datatype() == atlas::array::DataType::real32()) {
+        return executeFusedStage<float>(stageFields, plan, stage, columns);
+    } else if (product.datatype() == atlas::array::DataType::real64()) {
+        return executeFusedStage<double>(stageFields, plan, stage, columns);
+    }
+    return false;
+}
+// ------------------------------------------------------------------------------------------------
+template <typename T>
+bool Vader::executeFusedStage(std::vector<atlas::FieldSet> & stageFields,
+                              const ChangeVarPlan & plan,
+                              const ChangeVarPlan::Stage & stage,
+                              const ColumnSelection & columns) const {
+    // Field data for one recipe of the stage, for one member
+    struct Kernel {
+        const RecipeBase * recipe;
+        bool convert;  // evaluated in double precision, the fields being single precision
+        std::unique_ptr<RecipeContext> context;
+        std::vector<const T *> ingredients;
+        std::vector<atlas::idx_t> ingredientLevels;
+        T * product;
+        atlas::idx_t productLevels;
+    };
+
+    atlas::idx_t ncolumns = -1;
+    auto columnData = [&ncolumns](const atlas::Field & field, atlas::idx_t & levels) {
+        if (field.datatype() != atlas::array::DataType::create<T>()) {
+            return static_cast<T *>(nullptr);
+        }
+        auto view = atlas::array::make_view<T, 2>(field);
+        levels = view.shape(1);
+        if (view.stride(1) != 1 || view.stride(0) != levels) return static_cast<T *>(nullptr);
+        if (ncolumns < 0) ncolumns = view.shape(0);
+        if (view.shape(0) != ncolumns) return static_cast<T *>(nullptr);
+        return view.data();
+    };
+
+    // kernels[m * nsteps + k] is the k-th recipe of the stage for member m
+    const std::size_t nsteps = stage.steps.size();
+    std::vector<Kernel> kernels;
+    for (auto & fields : stageFields) {
+        for (auto i : stage.steps) {
+            const ChangeVarPlan::Step & step = plan.steps()[i];
+            Kernel kernel;
+            kernel.recipe = step.recipe;
+            kernel.convert = std::is_same<T, float>::value && !step.recipe->hasFloatColumnKernel();
+            for (auto ingredient : step.recipe->ingredients()) {
+                atlas::idx_t levels;
+                const T * data = columnData(fields.field(ingredient), levels);
+                if (data == nullptr) return false;
+                kernel.ingredients.push_back(data);
+                kernel.ingredientLevels.push_back(levels);
+            }
+            kernel.product = columnData(fields.field(step.variable), kernel.productLevels);
+            if (kernel.product == nullptr) return false;
+            kernels.push_back(std::move(kernel));
+        }
+    }
+
+    // The setup locks are taken in a fixed (address) order, so that concurrent stages
+    // sharing recipes cannot deadlock
+    std::vector<const ChangeVarPlan::Step *> lockOrder;
+    for (auto i : stage.steps) lockOrder.push_back(&plan.steps()[i]);
+    std::sort(lockOrder.begin(), lockOrder.end(),
+              [](const ChangeVarPlan::Step * a, const ChangeVarPlan::Step * b) {
+                  return std::less<const RecipeBase *>()(a->recipe, b->recipe);
+              });
+    std::vector<RecipeBase::SetupLock> setupLocks;
+    for (const ChangeVarPlan::Step * step : lockOrder) {
+        oops::Log::debug() << "Attempting to calculate variable " << step->variable <<
+            " using column kernel of recipe with name: " << step->recipe->name() << std::endl;
+        setupLocks.push_back(step->recipe->ensureSetup(stageFields.front()));
+        if (!setupLocks.back().owns_lock()) {
+            oops::Log::debug() << "Setup of recipe " << step->recipe->name() <<
+                " failed, stage executed recipe by recipe" << std::endl;
+            return false;
+        }
+    }
+    for (std::size_t m = 0; m < stageFields.size(); ++m) {
+        for (std::size_t k = 0; k < nsteps; ++k) {
+            Kernel & kernel = kernels[m * nsteps + k];
+            kernel.context = kernel.recipe->makeContext(stageFields[m]);
+            if (!kernel.context) {
+                oops::Log::debug() << "Recipe " << kernel.recipe->name() <<
+                    " cannot run its column kernel, stage executed recipe by recipe" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    std::string stageName;
+    for (auto i : stage.steps) {
+        stageName += (stageName.empty() ? "" : "+") + plan.steps()[i].recipe->name();
+    }
+    // Only the selected columns are swept
+    const atlas::idx_t nselected = columns.size(ncolumns);
+    const atlas::idx_t * selected = columns.all() ? nullptr : columns.columns().data();
+
+    ScopedKernelTimer timer(stageName, columns, stats_);
+    std::size_t points = 0;
+    for (const auto & fields : stageFields) {
+        for (auto i : stage.steps) {
+            for (const auto & ingredient : plan.steps()[i].recipe->ingredients()) {
+                timer.reads(fields.field(ingredient));
+            }
+            timer.writes(fields.field(plan.steps()[i].variable));
+        }
+        points += fields.field(plan.steps()[stage.steps.back()].variable).levels() * nselected;
+    }
+    timer.points(points);
+
+    // Sizes of the per-thread buffers
+    std::size_t maxIngredients = 0;
+    atlas::idx_t maxLevels = 0;
+    bool convert = false;
+    for (const Kernel & kernel : kernels) {
+        maxIngredients = std::max(maxIngredients, kernel.ingredients.size());
+        if (!kernel.convert) continue;
+        convert = true;
+        maxLevels = std::max(maxLevels, kernel.productLevels);
+        for (auto levels : kernel.ingredientLevels) maxLevels = std::max(maxLevels, levels);
+    }
+
+    const atlas::idx_t totalColumns = nselected * static_cast<atlas::idx_t>(stageFields.size());
+#pragma omp parallel
+    {
+        std::vector<const T *> ingredientColumns(maxIngredients);
+        // Double precision copies of the columns for the kernels that convert them
+        std::vector<std::vector<double>> ingredientBuffers(convert ? maxIngredients : 0,
+                                                           std::vector<double>(maxLevels));
+        std::vector<const double *> bufferColumns(convert ? maxIngredients : 0);
+        std::vector<double> productBuffer(convert ? maxLevels : 0);
+#pragma omp for schedule(static)
+        for (atlas::idx_t jcol = 0; jcol < totalColumns; ++jcol) {
+            const atlas::idx_t jnode = selected ? selected[jcol % nselected] : jcol % nselected;
+            const Kernel * memberKernels = &kernels[(jcol / nselected) * nsteps];
+            for (std::size_t k = 0; k < nsteps; ++k) {
+                const Kernel & kernel = memberKernels[k];
+                for (std::size_t j = 0; j < kernel.ingredients.size(); ++j) {
+                    ingredientColumns[j] = kernel.ingredients[j] +
+                                           jnode * kernel.ingredientLevels[j];
+                }
+                T * productColumn = kernel.product + jnode * kernel.productLevels;
+                if (!kernel.convert) {
+                    kernel.recipe->executeColumn(*kernel.context, ingredientColumns.data(),
+                                                 kernel.ingredientLevels.data(), productColumn,
+                                                 kernel.productLevels);
+                    continue;
+                }
+                for (std::size_t j = 0; j < kernel.ingredients.size(); ++j) {
+                    std::copy(ingredientColumns[j],
+                              ingredientColumns[j] + kernel.ingredientLevels[j],
+                              ingredientBuffers[j].begin());
+                    bufferColumns[j] = ingredientBuffers[j].data();
+                }
+                kernel.recipe->executeColumn(*kernel.context, bufferColumns.data(),
+                                             kernel.ingredientLevels.data(), productBuffer.data(),
+                                             kernel.productLevels);
+                std::copy(productBuffer.begin(), productBuffer.begin() + kernel.productLevels,
+                          productColumn);
+            }
+        }
+    }
+    return true;
+}
 
 }  // namespace vader
@@ -8,7 +8,9 @@
 #ifndef SRC_VADER_VADER_H_
 #define SRC_VADER_VADER_H_
 
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -16,8 +18,13 @@
 
 #include "atlas/field/FieldSet.h"
 #include "oops/base/Variables.h"
+#include "ChangeVarPlan.h"
+#include "ColumnSelection.h"
 #include "RecipeBase.h"
+#include "ScratchArena.h"
+#include "StatsRegistry.h"
 #include "VaderParameters.h"
+#include "VariableTable.h"
 
 
 namespace vader {
@@ -34,10 +41,20 @@ namespace vader {
  *           A 'recipe' is is an object that can produce a single output
  *           variable when provided with a list of required input variables.
  *           The input variables are referred to as the 'ingredients' to the
- *           recipe. The 'cookbook' is the container (an unordered_map) that
- *           contains the recipes to be attempted when specified output variable
- *           is desired. The cookbook can contain multiple recipes that produce
- *           the same output variable.
+ *           recipe. The 'cookbook' is the container that contains the recipes
+ *           to be attempted when specified output variable is desired. The
+ *           cookbook can contain multiple recipes that produce the same output
+ *           variable.
+ *
+ *           Internally, variables are identified by the integer ids of Vader's
+ *           VariableTable, and the cookbook is indexed by the id of the variable
+ *           the recipes produce.
+ *
+ *           A Vader is reentrant: its methods may be called concurrently from several
+ *           threads (e.g. for different time slots), on different FieldSets. Recipes
+ *           keep no state between executions besides what their setup prepares (see
+ *           RecipeBase), and the scratch arena, statistics and incremental records
+ *           are protected by mutexes.
  */
 
 class Vader {
@@ -46,24 +63,111 @@ class Vader {
     explicit Vader(const VaderParameters & parameters);
     ~Vader();
 
-    /// Calculates as many variables in the list as possible
-    oops::Variables changeVar(atlas::FieldSet &, oops::Variables &) const;
+    /// Calculates as many variables in the list as possible, at the selected columns
+    oops::Variables changeVar(atlas::FieldSet &, oops::Variables &,
+                              const ColumnSelection & = ColumnSelection()) const;
+    /// Creates a reusable plan for calculating as many variables in the list as possible
+    ChangeVarPlan compile(const std::vector<std::string> &, const oops::Variables &) const;
+    /// Calculates the variables of a plan previously created by compile
+    oops::Variables changeVar(atlas::FieldSet &, const ChangeVarPlan &,
+                              const ColumnSelection & = ColumnSelection()) const;
+    /// Calculates as many variables in the list as possible in every member of a batch
+    oops::Variables changeVar(std::vector<atlas::FieldSet *> &, oops::Variables &,
+                              const ColumnSelection & = ColumnSelection()) const;
+    /// Calculates the variables of a plan in every member of a batch
+    oops::Variables changeVar(std::vector<atlas::FieldSet *> &, const ChangeVarPlan &,
+                              const ColumnSelection & = ColumnSelection()) const;
+    /// Calculates as many variables in the list as possible, only re-executing the
+    /// recipes whose ingredients changed since the previous call for the same FieldSet
+    oops::Variables changeVarIncremental(atlas::FieldSet &, oops::Variables &) const;
+    /// Forgets what changeVarIncremental recorded for a FieldSet, and releases it
+    void forgetIncremental(const atlas::FieldSet &) const;
+    /// Statistics of the recipes executed by this Vader
+    const StatsRegistry & stats() const {return stats_;}
 
  private:
-    std::unordered_map<std::string, std::vector<std::unique_ptr<RecipeBase>>>
-        cookbook_;
+    /// A recipe in the cookbook, along with the ids of its ingredients and the weight
+    /// of its estimated cost.
+    struct CookbookEntry {
+        std::unique_ptr<RecipeBase> recipe;
+        std::vector<VariableTable::Id> ingredients;
+        double cost;
+    };
+
+    /// State of a variable during planning
+    enum class PlanState {unvisited, inProgress, planned, unavailable};
+    /// Recipe chosen to make a variable during planning, and the cost of making the
+    /// variable with it (including the cost of making its missing ingredients)
+    struct RecipeChoice {
+        PlanState state = PlanState::unvisited;
+        const CookbookEntry * entry = nullptr;
+        double cost = 0.0;
+    };
+
+    /// Identifies the contents of a field: its storage, and either the "version" in its
+    /// metadata or a hash of its values
+    struct FieldStamp {
+        const void * storage;
+        std::size_t bytes;
+        std::uint64_t contents;
+        bool operator==(const FieldStamp & other) const {
+            return storage == other.storage && bytes == other.bytes &&
+                   contents == other.contents;
+        }
+        bool operator!=(const FieldStamp & other) const {return !(*this == other);}
+    };
+    /// What changeVarIncremental recorded for a FieldSet: the FieldSet itself (held so
+    /// that its address is not reused by another FieldSet while the record exists), the
+    /// plan it executed and the stamps of the fields the plan read and wrote, as they
+    /// were when it finished. The mutex serialises the calls for the FieldSet.
+    struct IncrementalState {
+        atlas::FieldSet fieldset;
+        std::mutex mutex;
+        std::vector<std::string> neededVars;
+        ChangeVarPlan plan;
+        std::unordered_map<std::string, FieldStamp> stamps;
+    };
+
+    VariableTable variables_;
+    std::vector<std::vector<CookbookEntry>> cookbook_;
+    VariableTable::Set cyclicVars_;
+    bool concurrentRecipes_;
+    bool fuseColumnKernels_;
+    mutable ScratchArena scratchArena_;
+    mutable StatsRegistry stats_;
+    std::string statsFile_;
+    mutable std::mutex incrementalMutex_;
+    mutable std::unordered_map<const void *, std::shared_ptr<IncrementalState>>
+        incrementalStates_;
     std::unordered_map<std::string, std::vector<std::string>>
         getDefaultCookbookDef();
 
     void createCookbook(std::unordered_map<std::string, std::vector<std::string>>,
                         const std::vector<RecipeParametersWrapper> & allRecpParamWraps =
                               std::vector<RecipeParametersWrapper>());
-    bool planVariable(atlas::FieldSet & afieldset,
-                      oops::Variables & neededVars,
-                      const std::string targetVariable,
-                      std::vector<std::pair<std::string, std::string>> & plan) const;
-    void executePlanNL(atlas::FieldSet & afieldset,
-                       const std::vector<std::pair<std::string, std::string>> & mealPlan) const;
+    void buildCookbookGraph();
+    bool chooseRecipe(const VariableTable::Set & neededVars,
+                      const VariableTable::Id targetVariable,
+                      std::vector<RecipeChoice> & choices) const;
+    bool planVariable(const VariableTable::Set & allocatedVars,
+                      VariableTable::Set & neededVars,
+                      const VariableTable::Id targetVariable,
+                      std::vector<RecipeChoice> & choices,
+                      std::vector<ChangeVarPlan::Step> & plan) const;
+    void executePlanNL(const std::vector<atlas::FieldSet *> & members,
+                       const ChangeVarPlan & plan,
+                       const ColumnSelection & columns) const;
+    bool useColumnKernels(const ChangeVarPlan & plan, const ChangeVarPlan::Stage & stage) const;
+    static FieldStamp stamp(atlas::Field);
+    bool executeFusedStage(std::vector<atlas::FieldSet> & stageFields,
+                           const ChangeVarPlan & plan,
+                           const ChangeVarPlan::Stage & stage,
+                           const ColumnSelection & columns) const;
+    template <typename T>
+    bool executeFusedStage(std::vector<atlas::FieldSet> & stageFields,
+                           const ChangeVarPlan & plan,
+                           const ChangeVarPlan::Stage & stage,
+                           const ColumnSelection & columns) const;
 };
 
 }  // namespace vader
@@ -137,6 +137,27 @@ const char VV_EXT2[] = "volume_extinction_in_air_due_to_aerosol_particles_lambda
 const char VV_EXT3[] = "volume_extinction_in_air_due_to_aerosol_particles_lambda3";
 const char VV_AIRDENS[] = "moist_air_density";
 
+// All of the variable names above. These are the names Vader's variable table is
+// seeded with.
+const char * const VV_ALL[] = {
+    VV_SVP, VV_TV, VV_TS, VV_PT, VV_T, VV_MIXR, VV_Q, VV_U, VV_V, VV_PRS, VV_PRSI, VV_DELP, VV_PS,
+    VV_Z, VV_ZM, VV_ZI, VV_SFC_Z, VV_OZ, VV_CO2, VV_CLW, VV_CLI, VV_CLR, VV_CLS, VV_CLG, VV_CLH,
+    VV_CLWEFR, VV_CLIEFR, VV_CLREFR, VV_CLSEFR, VV_CLGEFR, VV_CLHEFR, VV_CLDFRAC, VV_SFC_P2M,
+    VV_SFC_Q2M, VV_SFC_T2M, VV_SFC_TSKIN, VV_SFC_WFRAC, VV_SFC_LFRAC, VV_SFC_IFRAC, VV_SFC_SFRAC,
+    VV_SFC_WTMP, VV_SFC_LTMP, VV_SFC_ITMP, VV_SFC_STMP, VV_SFC_SDEPTH, VV_SFC_VEGFRAC,
+    VV_SFC_WSPEED, VV_SFC_WDIR, VV_SFC_U10, VV_SFC_V10, VV_SFC_U, VV_SFC_V, VV_SFC_LAI,
+    VV_SFC_SOILM, VV_SFC_SOILT, VV_SFC_LANDTYP, VV_SFC_VEGTYP, VV_SFC_SOILTYP, VV_GEOMZ,
+    VV_SFC_GEOMZ, VV_SFC_ROUGH, VV_SFC_T, VV_SFC_FACT10, VV_SFC_EMISS, VV_SFC_SSS, VV_OPT_DEPTH,
+    VV_RADIANCE, VV_TB, VV_TB_CLR, VV_TOTAL_TRANSMIT, VV_LVL_TRANSMIT, VV_LVL_WEIGHTFUNC,
+    VV_PMAXLEV_WEIGHTFUNC, VV_TSAVG5, VV_SEA_FRIC_VEL, VV_REFL, VV_W, VV_RH, VV_WATER_TYPE_RTTOV,
+    VV_SURF_TYPE_RTTOV, VV_SFC_LANDMASK, VV_SFC_SEAICEFRAC, VV_SEAICEFRAC, VV_SEAICETHICK,
+    VV_SEAICESNOWTHICK, VV_OCN_CHL, VV_ABS_TOPO, VV_OCN_POT_TEMP, VV_OCN_CON_TEMP, VV_OCN_ABS_SALT,
+    VV_OCN_PRA_SALT, VV_OCN_SALT, VV_OCN_LAY_THICK, VV_OCN_SST, VV_SEA_TD, VV_LATENT_VAP, VV_SW_RAD,
+    VV_LATENT_HEAT, VV_SENS_HEAT, VV_LW_RAD, VV_DU001, VV_DU002, VV_DU003, VV_DU004, VV_DU005,
+    VV_SS001, VV_SS002, VV_SS003, VV_SS004, VV_SS005, VV_BCPHOBIC, VV_BCPHILIC, VV_OCPHOBIC,
+    VV_OCPHILIC, VV_SULFATE, VV_NO3AN1, VV_NO3AN2, VV_NO3AN3, VV_EXT1, VV_EXT2, VV_EXT3, VV_AIRDENS
+};
+
 }  // namespace vader
 
 #endif  // SRC_VADER_VADERVARIABLES_H_